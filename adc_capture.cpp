@@ -0,0 +1,112 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: adc_capture.cpp
+// description: capture raw adc blocks and send them to the host over usb
+// License: MIT
+//
+
+#include <string.h>
+#include "adc_capture.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "tusb.h"
+
+adc_capture::adc_capture()
+{
+  state = idle;
+  num_blocks = 0;
+  captured_blocks = 0;
+  next_block = 0;
+  nco_frequency_Hz = 0;
+  swap_iq = false;
+  bytes_sent = 0;
+  bytes_total = 0;
+  capture.header = {};
+}
+
+void __not_in_flash_func(adc_capture::capture_block)(const uint16_t samples[], uint32_t sequence)
+{
+  if(state == armed)
+  {
+    capture.header.magic = adc_capture_magic;
+    capture.header.header_size = sizeof(s_adc_capture_header);
+    capture.header.num_blocks = num_blocks;
+    capture.header.block_size = adc_block_size;
+    capture.header.flags = swap_iq ? adc_capture_flag_swap_iq : 0;
+    capture.header.sample_rate = adc_sample_rate;
+    capture.header.first_block = sequence;
+    capture.header.nco_frequency_Hz = nco_frequency_Hz;
+    captured_blocks = 0;
+    next_block = sequence;
+    state = running;
+  }
+  if(state != running) return;
+
+  //a missed deadline or a restart of the adc leaves a gap
+  if(sequence != next_block)
+  {
+    capture.header.flags |= adc_capture_flag_discontinuous;
+  }
+  next_block = sequence + 1;
+
+  memcpy(&capture.samples[captured_blocks * adc_block_size], samples, adc_block_size * sizeof(uint16_t));
+  if(++captured_blocks == num_blocks)
+  {
+    __dmb();
+    state = ready;
+  }
+}
+
+void adc_capture::service()
+{
+  //a capture being sent when the host goes away is discarded
+  if(!tud_vendor_mounted())
+  {
+    if(state == ready || state == sending) state = idle;
+    return;
+  }
+
+  //commands are two bytes, the command and the number of blocks
+  uint8_t command[2];
+  while(tud_vendor_available() >= sizeof(command))
+  {
+    tud_vendor_read(command, sizeof(command));
+    if(command[0] != adc_capture_command || state != idle) continue;
+    num_blocks = command[1] < 1 ? 1 : command[1];
+    num_blocks = num_blocks > adc_capture_max_blocks ? adc_capture_max_blocks : num_blocks;
+    __dmb();
+    state = armed;
+  }
+
+  if(state == ready)
+  {
+    __dmb();
+    bytes_sent = 0;
+    bytes_total = sizeof(s_adc_capture_header) + num_blocks * adc_block_size * sizeof(uint16_t);
+    state = sending;
+  }
+
+  //send straight from the capture buffer as space becomes available
+  if(state == sending)
+  {
+    const uint8_t *data = (const uint8_t*)&capture;
+    uint32_t available = tud_vendor_write_available();
+    const uint32_t remaining = bytes_total - bytes_sent;
+    available = available < remaining ? available : remaining;
+    if(available)
+    {
+      bytes_sent += tud_vendor_write(&data[bytes_sent], available);
+      tud_vendor_write_flush();
+    }
+    if(bytes_sent == bytes_total)
+    {
+      state = idle;
+    }
+  }
+}
@@ -0,0 +1,82 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: adc_capture.h
+// description: capture raw adc blocks and send them to the host over usb
+// License: MIT
+//
+
+#ifndef ADC_CAPTURE_H
+#define ADC_CAPTURE_H
+#include <stdint.h>
+#include "rx_definitions.h"
+
+static const uint8_t adc_capture_max_blocks = 4u;
+static const uint32_t adc_capture_magic = 0x43585250u; //"PRXC"
+
+//host to device command, followed by the number of blocks
+static const uint8_t adc_capture_command = 'C';
+
+//capture flags
+static const uint16_t adc_capture_flag_discontinuous = 1u; //blocks were missed during the capture
+static const uint16_t adc_capture_flag_swap_iq = 2u;       //odd samples hold I
+
+//All fields are little endian. The samples follow the header directly, so
+//the capture is sent to the host as one contiguous block of memory.
+struct s_adc_capture_header
+{
+  uint32_t magic;
+  uint16_t header_size;  //bytes
+  uint16_t num_blocks;
+  uint16_t block_size;   //samples per block
+  uint16_t flags;
+  uint32_t sample_rate;  //Hz, I and Q samples alternate
+  uint32_t first_block;  //block sequence number of the first block
+  uint32_t nco_frequency_Hz;
+  uint32_t reserved[2];
+};
+
+//The host arms a capture, core 1 copies the next N consecutive adc blocks
+//before they are processed, and the usb task sends the header and samples
+//over the vendor bulk endpoint. Only one capture is in flight at a time.
+class adc_capture
+{
+  enum e_state {idle, armed, running, ready, sending};
+  volatile uint8_t state;
+
+  struct
+  {
+    s_adc_capture_header header;
+    uint16_t samples[adc_capture_max_blocks * adc_block_size];
+  } capture;
+
+  //set when armed, then used by core 1
+  uint16_t num_blocks;
+
+  //core 1
+  uint16_t captured_blocks;
+  uint32_t next_block;
+  uint32_t nco_frequency_Hz;
+  bool swap_iq;
+
+  //usb task
+  uint32_t bytes_sent;
+  uint32_t bytes_total;
+
+  public:
+  adc_capture();
+
+  //core 1, copies the block if a capture is in progress
+  void set_front_end(uint32_t frequency_Hz, bool swap){nco_frequency_Hz = frequency_Hz; swap_iq = swap;}
+  void capture_block(const uint16_t samples[], uint32_t sequence);
+
+  //usb task, handles commands and sends completed captures
+  void service();
+};
+
+#endif
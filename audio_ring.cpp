@@ -0,0 +1,78 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: audio_ring.cpp
+// description: single producer single consumer ring of audio samples
+// License: MIT
+//
+
+#include "audio_ring.h"
+#include <string.h>
+
+#ifndef SIMULATION
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#else
+static inline void __dmb(){}
+#endif
+
+audio_ring::audio_ring()
+{
+  head = 0;
+  tail = 0;
+  dropped = 0;
+}
+
+#ifndef SIMULATION
+uint16_t __not_in_flash_func(audio_ring::push)(const int16_t new_samples[], uint16_t num_samples)
+#else
+uint16_t audio_ring::push(const int16_t new_samples[], uint16_t num_samples)
+#endif
+{
+  const uint32_t space = audio_ring_size - (head - tail);
+  if(num_samples > space)
+  {
+    dropped += num_samples - space;
+    num_samples = space;
+  }
+
+  //copy in up to two spans
+  const uint16_t start = head & (audio_ring_size - 1u);
+  const uint16_t first = num_samples < audio_ring_size - start ? num_samples : audio_ring_size - start;
+  memcpy(&samples[start], new_samples, first * sizeof(int16_t));
+  memcpy(&samples[0], &new_samples[first], (num_samples - first) * sizeof(int16_t));
+
+  //samples must be visible before the index moves
+  __dmb();
+  head = head + num_samples;
+  return num_samples;
+}
+
+#ifndef SIMULATION
+uint16_t __not_in_flash_func(audio_ring::get_read_span)(const int16_t *&span)
+#else
+uint16_t audio_ring::get_read_span(const int16_t *&span)
+#endif
+{
+  const uint32_t available = head - tail;
+  __dmb();
+  const uint16_t start = tail & (audio_ring_size - 1u);
+  const uint32_t to_end = audio_ring_size - start;
+  span = &samples[start];
+  return available < to_end ? available : to_end;
+}
+
+#ifndef SIMULATION
+void __not_in_flash_func(audio_ring::consume)(uint16_t num_samples)
+#else
+void audio_ring::consume(uint16_t num_samples)
+#endif
+{
+  __dmb();
+  tail = tail + num_samples;
+}
@@ -0,0 +1,44 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: audio_ring.h
+// description: single producer single consumer ring of audio samples
+// License: MIT
+//
+
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+#include <stdint.h>
+
+static const uint16_t audio_ring_size = 2048u; //power of 2, holds the longest usb latency in stereo
+
+//The producer only writes head and the consumer only writes tail, so no
+//locks are needed between cores or with interrupts. Indices run freely and
+//are masked on access. A full ring drops the newest samples.
+class audio_ring
+{
+  int16_t samples[audio_ring_size];
+  volatile uint32_t head;
+  volatile uint32_t tail;
+  uint32_t dropped;
+
+  public:
+  audio_ring();
+
+  //producer, returns the number of samples written
+  uint16_t push(const int16_t new_samples[], uint16_t num_samples);
+  uint32_t get_dropped(){return dropped;}
+
+  //consumer, read in place from up to two contiguous spans
+  uint16_t get_read_span(const int16_t *&span);
+  void consume(uint16_t num_samples);
+
+  uint16_t get_num_samples(){return head - tail;}
+};
+
+#endif
@@ -0,0 +1,171 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: biquad_filter.cpp
+// description: fixed point biquad cascade used for all audio shaping
+// License: MIT
+//
+
+#include "biquad_filter.h"
+#include <cmath>
+
+#ifndef SIMULATION
+#include "pico/stdlib.h"
+#endif
+
+biquad_filter::biquad_filter()
+{
+  clear();
+}
+
+void biquad_filter::clear()
+{
+  num_sections = 0;
+}
+
+void biquad_filter::reset()
+{
+  for(uint8_t s=0; s<biquad_max_sections; ++s)
+  {
+    sections[s].x1 = 0;
+    sections[s].x2 = 0;
+    sections[s].y1 = 0;
+    sections[s].y2 = 0;
+    sections[s].error = 0;
+  }
+}
+
+void biquad_filter::update(const biquad_filter &design)
+{
+  for(uint8_t s=0; s<design.num_sections; ++s)
+  {
+    s_biquad_section &section = sections[s];
+    const s_biquad_section &new_section = design.sections[s];
+    const bool unchanged = s < num_sections &&
+      section.b0 == new_section.b0 && section.b1 == new_section.b1 && section.b2 == new_section.b2 &&
+      section.a1 == new_section.a1 && section.a2 == new_section.a2;
+    if(!unchanged) section = new_section;
+  }
+  num_sections = design.num_sections;
+}
+
+void biquad_filter::add_section(float b0, float b1, float b2, float a0, float a1, float a2)
+{
+  if(num_sections == biquad_max_sections) return;
+
+  //normalise so that a0 = 1 and convert to fixed point
+  const float scale = (1 << biquad_fraction_bits)/a0;
+  s_biquad_section &section = sections[num_sections++];
+  section.b0 = roundf(b0 * scale);
+  section.b1 = roundf(b1 * scale);
+  section.b2 = roundf(b2 * scale);
+  section.a1 = roundf(a1 * scale);
+  section.a2 = roundf(a2 * scale);
+  section.x1 = 0;
+  section.x2 = 0;
+  section.y1 = 0;
+  section.y2 = 0;
+  section.error = 0;
+}
+
+//single pole low-pass (e.g. FM de-emphasis), bilinear transform with pre-warping
+void biquad_filter::add_first_order_lowpass(float tau_s, float fs)
+{
+  const float k = tanf(1.0f/(2.0f * tau_s * fs));
+  add_section(k, k, 0.0f, 1.0f + k, k - 1.0f, 0.0f);
+}
+
+//remaining designs are from the RBJ audio EQ cookbook
+void biquad_filter::add_highpass(float frequency_Hz, float q, float fs)
+{
+  const float w0 = 2.0f * (float)M_PI * frequency_Hz / fs;
+  const float cos_w0 = cosf(w0);
+  const float alpha = sinf(w0)/(2.0f * q);
+  add_section((1.0f + cos_w0)/2.0f, -(1.0f + cos_w0), (1.0f + cos_w0)/2.0f,
+              1.0f + alpha, -2.0f * cos_w0, 1.0f - alpha);
+}
+
+//constant 0dB peak gain
+void biquad_filter::add_bandpass(float frequency_Hz, float q, float fs)
+{
+  const float w0 = 2.0f * (float)M_PI * frequency_Hz / fs;
+  const float cos_w0 = cosf(w0);
+  const float alpha = sinf(w0)/(2.0f * q);
+  add_section(alpha, 0.0f, -alpha, 1.0f + alpha, -2.0f * cos_w0, 1.0f - alpha);
+}
+
+void biquad_filter::add_low_shelf(float frequency_Hz, float gain_dB, float fs)
+{
+  const float a = powf(10.0f, gain_dB/40.0f);
+  const float w0 = 2.0f * (float)M_PI * frequency_Hz / fs;
+  const float cos_w0 = cosf(w0);
+  const float beta = sinf(w0) * sqrtf(a) * (float)M_SQRT1_2 * 2.0f; //shelf slope S=1
+  add_section(a * ((a + 1.0f) - (a - 1.0f) * cos_w0 + beta),
+              2.0f * a * ((a - 1.0f) - (a + 1.0f) * cos_w0),
+              a * ((a + 1.0f) - (a - 1.0f) * cos_w0 - beta),
+              (a + 1.0f) + (a - 1.0f) * cos_w0 + beta,
+              -2.0f * ((a - 1.0f) + (a + 1.0f) * cos_w0),
+              (a + 1.0f) + (a - 1.0f) * cos_w0 - beta);
+}
+
+void biquad_filter::add_high_shelf(float frequency_Hz, float gain_dB, float fs)
+{
+  const float a = powf(10.0f, gain_dB/40.0f);
+  const float w0 = 2.0f * (float)M_PI * frequency_Hz / fs;
+  const float cos_w0 = cosf(w0);
+  const float beta = sinf(w0) * sqrtf(a) * (float)M_SQRT1_2 * 2.0f; //shelf slope S=1
+  add_section(a * ((a + 1.0f) + (a - 1.0f) * cos_w0 + beta),
+              -2.0f * a * ((a - 1.0f) + (a + 1.0f) * cos_w0),
+              a * ((a + 1.0f) + (a - 1.0f) * cos_w0 - beta),
+              (a + 1.0f) - (a - 1.0f) * cos_w0 + beta,
+              2.0f * ((a - 1.0f) - (a + 1.0f) * cos_w0),
+              (a + 1.0f) - (a - 1.0f) * cos_w0 - beta);
+}
+
+#ifndef SIMULATION
+void __not_in_flash_func(biquad_filter::process_block)(int16_t samples[], uint16_t num_samples)
+#else
+void biquad_filter::process_block(int16_t samples[], uint16_t num_samples)
+#endif
+{
+  //run each section over the whole block so that coefficients and state
+  //stay in registers for the inner loop
+  for(uint8_t s=0; s<num_sections; ++s)
+  {
+    s_biquad_section &section = sections[s];
+    const int32_t b0 = section.b0, b1 = section.b1, b2 = section.b2;
+    const int32_t a1 = section.a1, a2 = section.a2;
+    int32_t x1 = section.x1, x2 = section.x2;
+    int32_t y1 = section.y1, y2 = section.y2;
+    int32_t error = section.error;
+
+    for(uint16_t idx=0; idx<num_samples; ++idx)
+    {
+      const int32_t x = samples[idx];
+
+      //the truncated fraction is fed back into the next sample, this stops
+      //the low frequency sections from accumulating truncation noise/bias
+      const int32_t accumulator = b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2 + error;
+      int32_t y = accumulator >> biquad_fraction_bits;
+      error = accumulator - (y << biquad_fraction_bits);
+
+      if(y > INT16_MAX) y = INT16_MAX;
+      if(y < INT16_MIN) y = INT16_MIN;
+
+      x2 = x1;
+      x1 = x;
+      y2 = y1;
+      y1 = y;
+      samples[idx] = y;
+    }
+
+    section.x1 = x1; section.x2 = x2;
+    section.y1 = y1; section.y2 = y2;
+    section.error = error;
+  }
+}
@@ -0,0 +1,68 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: biquad_filter.h
+// description: fixed point biquad cascade used for all audio shaping
+// License: MIT
+//
+
+#ifndef BIQUAD_FILTER_H
+#define BIQUAD_FILTER_H
+#include <stdint.h>
+
+//coefficients are stored with 12 fractional bits, a 16 bit sample times
+//a coefficient sum of up to 16 then fits in the 32 bit accumulator
+static const uint8_t biquad_fraction_bits = 12u;
+static const uint8_t biquad_max_sections = 4u;
+
+struct s_biquad_section
+{
+  //feed forward (b) and feedback (a) coefficients, a0 is normalised to 1
+  int32_t b0, b1, b2;
+  int32_t a1, a2;
+
+  //direct form I state
+  int16_t x1, x2;
+  int16_t y1, y2;
+  int32_t error;
+};
+
+class biquad_filter
+{
+  s_biquad_section sections[biquad_max_sections];
+  uint8_t num_sections;
+
+  void add_section(float b0, float b1, float b2, float a0, float a1, float a2);
+
+  public:
+  biquad_filter();
+
+  //remove all sections (filter becomes a pass-through)
+  void clear();
+
+  //clear filter state without changing the coefficients
+  void reset();
+
+  //take the coefficients of another cascade, sections whose coefficients
+  //are unchanged keep their state so re-applying settings doesn't click
+  void update(const biquad_filter &design);
+
+  //append sections to the cascade, frequencies are in Hz, fs is the sample rate
+  void add_first_order_lowpass(float tau_s, float fs);
+  void add_highpass(float frequency_Hz, float q, float fs);
+  void add_bandpass(float frequency_Hz, float q, float fs);
+  void add_low_shelf(float frequency_Hz, float gain_dB, float fs);
+  void add_high_shelf(float frequency_Hz, float gain_dB, float fs);
+
+  uint8_t get_num_sections(){return num_sections;}
+
+  //filter a block of samples in place
+  void process_block(int16_t samples[], uint16_t num_samples);
+};
+
+#endif
@@ -2,320 +2,438 @@
 #include "ui.h"
 
 #include <algorithm>
+#include <string.h>
 
 #include "pico/stdlib.h"
 
-void process_cat_control(rx_settings & settings_to_apply, rx_status & status, rx &receiver, uint32_t settings[])
+//Commands are two upper case letters, optional parameters and ';'. Bytes
+//are consumed as they arrive without waiting, each complete command is
+//dispatched through a table indexed by its two letters, and replies are
+//formatted with integer routines into a buffer that is sent in one write.
+
+static const uint8_t cat_max_command = 32u;  //including ';', longer commands are rejected
+static const uint8_t cat_max_bytes = 64u;    //read per call, bounds the time taken
+static const uint16_t cat_max_reply = 512u;  //sent when half full, holds the longest reply
+
+struct s_cat_context
+{
+  rx_settings &settings_to_apply;
+  rx_status &status;
+  rx &receiver;
+  uint32_t *settings;
+  task_scheduler &scheduler;
+  const char *params; //after the two letters, terminated by ';'
+  uint8_t num_params;
+  bool settings_changed;
+};
+
+//reply buffer
+static char reply[cat_max_reply];
+static uint16_t reply_length = 0;
+
+static void put_char(char c)
+{
+    if(reply_length < cat_max_reply) reply[reply_length++] = c;
+}
+
+static void put_string(const char *s)
+{
+    while(*s) put_char(*s++);
+}
+
+static void put_decimal(uint32_t value, uint8_t width)
 {
-    const uint16_t buffer_length = 64;
-    static char buf[buffer_length];
-    static uint16_t read_idx = 0;
-    static uint16_t write_idx = 0;
-    static uint16_t items_in_buffer = 0;
+    char digits[10];
+    uint8_t num_digits = 0;
+    do
+    {
+      digits[num_digits++] = '0' + value % 10u;
+      value /= 10u;
+    } while(value);
+    while(width > num_digits) {put_char('0'); --width;}
+    while(num_digits) put_char(digits[--num_digits]);
+}
 
-    //write any new data into circular buffer
+static void put_hex(uint32_t value, uint8_t width)
+{
+    while(width--) put_char("0123456789ABCDEF"[(value >> (4u * width)) & 0xfu]);
+}
+
+static void flush_reply()
+{
+    if(reply_length)
     {
-      const uint16_t bytes_to_end = buffer_length-write_idx-1;
-      if(bytes_to_end > 0)
-      {
-        int32_t retval = stdio_get_until(buf+write_idx, bytes_to_end, make_timeout_time_us(100));
-        if(retval != PICO_ERROR_TIMEOUT)
+      stdio_put_string(reply, reply_length, false, false);
+      reply_length = 0;
+    }
+}
+
+static void put_error()
+{
+    put_string("?;");
+}
+
+static bool parse_decimal(const s_cat_context &context, uint32_t &value)
+{
+    if(!context.num_params) return false;
+    value = 0;
+    for(uint8_t i = 0; i < context.num_params; ++i)
+    {
+      const char c = context.params[i];
+      if(c < '0' || c > '9' || value >= 100000000u) return false;
+      value = value * 10u + (c - '0');
+    }
+    return true;
+}
+
+static const char mode_translation[] = "551243";
+
+static void cat_fa(s_cat_context &context)
+{
+    // Handle frequency set/get commands
+    if (!context.num_params) {
+        put_string("FA");
+        put_decimal(context.settings[idx_frequency], 11);
+        put_char(';');
+    } else {
+        uint32_t frequency_Hz;
+        if(parse_decimal(context, frequency_Hz) && frequency_Hz <= 30000000)
         {
-          items_in_buffer += retval;
-          write_idx += retval;
-          if(write_idx > buffer_length) write_idx -= buffer_length;
+          context.settings[idx_frequency]=frequency_Hz;
+          context.settings_changed = true;
         }
-      }
-      else
-      {
-        int32_t retval = stdio_get_until(buf, sizeof(buf)-items_in_buffer, make_timeout_time_us(100));
-        if(retval != PICO_ERROR_TIMEOUT)
+        else
         {
-          items_in_buffer += retval;
-          write_idx += retval;
-          if(write_idx > buffer_length) write_idx -= buffer_length;
+          put_error();
         }
-      }
     }
+}
 
+static void cat_sm(s_cat_context &context)
+{
+    // Handle signal meter get commands, SM followed by a single digit
+    if (context.num_params == 1) {
+        context.receiver.access(false);
+        int32_t power_dBm = context.status.signal_strength_dBm;
+        context.receiver.release();
+        int32_t power_scaled = 16*(power_dBm - (-127))/114;
+        power_scaled = std::min((int32_t)0x20, power_scaled);
+        power_scaled = std::max((int32_t)0, power_scaled);
+        put_string("SM");
+        put_hex(power_scaled, 5);
+        put_char(';');
+    } else {
+        put_error();
+    }
+}
 
-    //copy command from circular buffer to command buffer
-    static char cmd[buffer_length];
-    const uint16_t bytes_to_read = items_in_buffer;
-    const uint16_t bytes_to_end = std::min(bytes_to_read, (uint16_t)(buffer_length-1u-read_idx));
-    const uint16_t bytes_remaining = bytes_to_read - bytes_to_end;
-    memcpy(cmd, buf+read_idx, bytes_to_end);
-    memcpy(cmd+bytes_to_end, buf, bytes_remaining);
-
-    //read command from circular_buffer
-    char *command_end = (char*)memchr(cmd, ';', items_in_buffer);
-    if(command_end == NULL) {
-      //buffer full discard
-      if(items_in_buffer == buffer_length){
-        items_in_buffer = 0;
-        read_idx = 0;
-        write_idx = 0;
-      }
+static void cat_md(s_cat_context &context)
+{
+    // Handle mode set/get commands
+    static const uint8_t modes[] = {MODE_LSB, MODE_USB, MODE_CW, MODE_FM, MODE_AM};
+    if (!context.num_params) {
+        put_string("MD");
+        put_char(mode_translation[context.settings[idx_mode]]);
+        put_char(';');
+    } else if (context.params[0] >= '1' && context.params[0] <= '5') {
+        context.settings_changed = true;
+        context.settings[idx_mode] = modes[context.params[0] - '1'];
+    }
+}
+
+static void cat_if(s_cat_context &context)
+{
+    if (!context.num_params) {
+        put_string("IF");
+        put_decimal(context.settings[idx_frequency], 11);
+        put_string("00000+0000000000");
+        put_char(mode_translation[context.settings[idx_mode]]);
+        put_string("0000000;");
+    }
+}
+
+static void cat_tx(s_cat_context &context)
+{
+    static uint8_t tx_status = 0;
+
+    // Set or Get TX mode command (TX)
+    if (!context.num_params) {
+        // Get current transmit status
+        put_string("TX");
+        put_decimal(tx_status, 1);
+        put_char(';');
+    } else if (context.params[0] == '1') {
+        // Switch to TX mode
+        tx_status = 1;
+    } else if (context.params[0] == '0') {
+        // Switch to RX mode
+        tx_status = 0;
+    } else {
+        // Invalid TX command format
+        put_error();
+    }
+}
+
+static void cat_dt(s_cat_context &context)
+{
+    // Real-time telemetry (non standard): blocks, missed, overflows, late irqs, events
+    if (context.num_params) {put_error(); return;}
+    const rx_status &status = context.status;
+    context.receiver.access(false);
+    put_string("DT");
+    put_hex(status.adc_blocks, 8);
+    put_hex(status.blocks_missed, 8);
+    put_hex(status.adc_overflows, 8);
+    put_hex(status.irq_late, 8);
+    put_hex(status.num_events, 8);
+    put_char(';');
+    context.receiver.release();
+}
+
+static void cat_de(s_cat_context &context)
+{
+    // Recent real-time events (non standard), oldest first: type, block, time
+    if (context.num_params) {put_error(); return;}
+    const rx_status &status = context.status;
+    context.receiver.access(false);
+    const uint32_t num_events = std::min(status.num_events, (uint32_t)rx_event_log_size);
+    for(uint32_t i = status.num_events - num_events; i < status.num_events; ++i)
+    {
+      const s_rx_event &event = status.events[i % rx_event_log_size];
+      put_string("DE");
+      put_char("DOIPB"[event.type]);
+      put_hex(event.sequence, 8);
+      put_hex(event.time_us, 8);
+      put_char(';');
+    }
+    if(!num_events) put_string("DE;");
+    context.receiver.release();
+}
+
+static void cat_du(s_cat_context &context)
+{
+    // USB jitter buffer (non standard): underruns, overruns, min and max level in samples,
+    // achieved and target latency in ms
+    if (context.num_params) {put_error(); return;}
+    const rx_status &status = context.status;
+    context.receiver.access(false);
+    put_string("DU");
+    put_hex(status.usb_underruns, 8);
+    put_hex(status.usb_overruns, 8);
+    put_hex(status.usb_min_level, 4);
+    put_hex(status.usb_max_level, 4);
+    put_hex(status.usb_latency_ms, 4);
+    put_hex(status.usb_target_latency_ms, 4);
+    put_char(';');
+    context.receiver.release();
+}
+
+static void cat_ds(s_cat_context &context)
+{
+    // Core 0 task statistics (non standard): per task name, runs, overruns, busy ms, longest run us,
+    // then idle and elapsed ms
+    if (context.num_params) {put_error(); return;}
+    task_scheduler &scheduler = context.scheduler;
+    for(uint8_t i = 0; i < scheduler.get_num_tasks(); ++i)
+    {
+      const s_task &task = scheduler.get_task(i);
+      put_string("DS");
+      put_string(task.name);
+      put_char(',');
+      put_hex(task.runs, 8);
+      put_hex(task.overruns, 8);
+      put_hex((uint32_t)(task.busy_us/1000u), 8);
+      put_hex(task.max_us, 8);
+      put_char(';');
+    }
+    put_string("DSidle,");
+    put_hex((uint32_t)(scheduler.get_idle_us()/1000u), 8);
+    put_hex((uint32_t)(scheduler.get_elapsed_us()/1000u), 8);
+    put_char(';');
+}
+
+//Commands with a handler, or a fixed reply to the query form (fake TX for now)
+struct s_cat_command
+{
+  char name[3];
+  void (*handler)(s_cat_context &context);
+  const char *reply;
+};
+
+static constexpr s_cat_command cat_commands[] = {
+  {"FA", cat_fa, nullptr},
+  {"SM", cat_sm, nullptr},
+  {"MD", cat_md, nullptr},
+  {"IF", cat_if, nullptr},
+  {"TX", cat_tx, nullptr},
+  {"DT", cat_dt, nullptr},
+  {"DE", cat_de, nullptr},
+  {"DU", cat_du, nullptr},
+  {"DS", cat_ds, nullptr},
+  {"ID", nullptr, "ID020;"},
+  {"AI", nullptr, "AI0;"},
+  {"AG", nullptr, "AG0;"},
+  {"XT", nullptr, "XT1;"},
+  {"RT", nullptr, "RT1;"},
+  {"RC", nullptr, "RC;"},
+  {"FL", nullptr, "FL0;"},
+  {"PS", nullptr, "PS1;"},
+  {"VX", nullptr, "VX0;"},
+  {"RS", nullptr, "RS0;"},
+  {"AC", nullptr, "AC010;"},
+  {"PR", nullptr, "PR0;"},
+  {"NB", nullptr, "NB0;"},
+  {"LK", nullptr, "LK00;"},
+  {"MG", nullptr, "MG000;"},
+  {"PL", nullptr, "PL000000;"},
+  {"VD", nullptr, "VD0000;"},
+  {"VG", nullptr, "VG000;"},
+  {"BC", nullptr, "BC0;"},
+  {"ML", nullptr, "ML000;"},
+  {"NR", nullptr, "NR0;"},
+  {"SD", nullptr, "SD0000;"},
+  {"KS", nullptr, "KS010;"},
+  {"EX", nullptr, "EX000000000;"},
+  {"RL", nullptr, "RL00;"},
+  {"SQ", nullptr, "SQ0000;"},
+  {"RG", nullptr, "RG000;"},
+  {"RM", nullptr, "RM10000;"},
+  {"PA", nullptr, "PA00;"},
+  {"RA", nullptr, "RA0000;"},
+  {"GT", nullptr, "GT000;"},
+  {"PC", nullptr, "PC005;"},
+  {"FW", nullptr, "FW0000;"},
+};
+static const uint8_t num_cat_commands = sizeof(cat_commands)/sizeof(cat_commands[0]);
+
+//Two letters hash without collisions to one of 26*26 slots, each holds the
+//index of the command or 0xff. Built at compile time.
+static constexpr uint16_t cat_hash(char a, char b)
+{
+  return (a - 'A') * 26 + (b - 'A');
+}
+
+struct s_cat_lookup
+{
+  uint8_t index[26*26];
+  constexpr s_cat_lookup() : index()
+  {
+    for(uint16_t i = 0; i < 26*26; ++i) index[i] = 0xff;
+    for(uint8_t i = 0; i < num_cat_commands; ++i)
+    {
+      index[cat_hash(cat_commands[i].name[0], cat_commands[i].name[1])] = i;
+    }
+  }
+};
+static constexpr s_cat_lookup cat_lookup;
+
+static void dispatch(s_cat_context &context, const char command[], uint8_t length)
+{
+    //length includes the ';'
+    const char a = command[0], b = command[1];
+    if(length < 3 || a < 'A' || a > 'Z' || b < 'A' || b > 'Z')
+    {
+      put_error();
       return;
     }
 
-    //remove the command from circular buffer
-    uint32_t command_length = command_end - cmd + 1;
-    read_idx += command_length;
-    if(read_idx > buffer_length) read_idx -= buffer_length;
-    items_in_buffer -= command_length;
-
-    bool settings_changed = false;
-    const char mode_translation[] = "551243";
-
-    if (strncmp(cmd, "FA", 2) == 0) {
-
-        // Handle mode set/get commands
-        if (cmd[2] == ';') {
-            printf("FA%011lu;", settings[idx_frequency]);
-        } else {
-            uint32_t frequency_Hz;
-            sscanf(cmd+2, "%lu", &frequency_Hz);
-            if(frequency_Hz <= 30000000)
-            {
-              settings[idx_frequency]=frequency_Hz;
-              settings_changed = true;
-            }
-            else
-            {
-              stdio_puts_raw("?;");
-            }
-        }
+    const uint8_t index = cat_lookup.index[cat_hash(a, b)];
+    if(index == 0xff)
+    {
+      // Unknown command
+      put_error();
+      return;
+    }
 
-    } else if (strncmp(cmd, "SM", 2) == 0) {
-
-        // Handle mode set/get commands
-        if (cmd[3] == ';') {
-            receiver.access(false);
-            float power_dBm = status.signal_strength_dBm;
-            receiver.release();
-            float power_scaled = 020*((power_dBm - (-127))/114);
-            power_scaled = std::min((float)0x20, power_scaled);
-            power_scaled = std::max((float)0, power_scaled);
-            printf("SM%05X;", (uint16_t)power_scaled);
-        } else {
-            stdio_puts_raw("?;");
-        }
+    context.params = command + 2;
+    context.num_params = length - 3;
+    const s_cat_command &entry = cat_commands[index];
+    if(entry.handler)
+    {
+      entry.handler(context);
+    }
+    else if(!context.num_params)
+    {
+      put_string(entry.reply);
+    }
+}
 
-    } else if (strncmp(cmd, "MD", 2) == 0) {
-
-        // Handle mode set/get commands
-        if (cmd[2] == ';') {
-            char mode_status = mode_translation[settings[idx_mode]];
-            printf("MD%c;", mode_status);
-        } else if (cmd[2] == '1') {
-            settings_changed = true;
-            settings[idx_mode] = MODE_LSB;
-        } else if (cmd[2] == '2') {
-            settings_changed = true;
-            settings[idx_mode] = MODE_USB;
-        } else if (cmd[2] == '3') {
-            settings_changed = true;
-            settings[idx_mode] = MODE_CW;
-        } else if (cmd[2] == '4') {
-            settings_changed = true;
-            settings[idx_mode] = MODE_FM;
-        } else if (cmd[2] == '5') {
-            settings_changed = true;
-            settings[idx_mode] = MODE_AM;
-        }
+static void apply_cat_settings(rx_settings & settings_to_apply, rx &receiver, uint32_t settings[])
+{
+    receiver.access(true);
+    settings_to_apply.tuned_frequency_Hz = settings[idx_frequency];
+    settings_to_apply.agc_speed = settings[idx_agc_speed];
+    settings_to_apply.enable_auto_notch = settings[idx_rx_features] >> flag_enable_auto_notch & 1;
+    settings_to_apply.mode = settings[idx_mode];
+    settings_to_apply.volume = settings[idx_volume];
+    settings_to_apply.squelch = settings[idx_squelch];
+    settings_to_apply.step_Hz = step_sizes[settings[idx_step]];
+    settings_to_apply.cw_sidetone_Hz = settings[idx_cw_sidetone]*100;
+    settings_to_apply.gain_cal = settings[idx_gain_cal];
+    settings_to_apply.suspend = false;
+    settings_to_apply.swap_iq = (settings[idx_hw_setup] >> flag_swap_iq) & 1;
+    settings_to_apply.bandwidth = (settings[idx_bandwidth_spectrum] & mask_bandwidth) >> flag_bandwidth;
+    settings_to_apply.deemphasis = (settings[idx_rx_features] & mask_deemphasis) >> flag_deemphasis;
+    settings_to_apply.band_1_limit = ((settings[idx_band1] >> 0) & 0xff);
+    settings_to_apply.band_2_limit = ((settings[idx_band1] >> 8) & 0xff);
+    settings_to_apply.band_3_limit = ((settings[idx_band1] >> 16) & 0xff);
+    settings_to_apply.band_4_limit = ((settings[idx_band1] >> 24) & 0xff);
+    settings_to_apply.band_5_limit = ((settings[idx_band2] >> 0) & 0xff);
+    settings_to_apply.band_6_limit = ((settings[idx_band2] >> 8) & 0xff);
+    settings_to_apply.band_7_limit = ((settings[idx_band2] >> 16) & 0xff);
+    settings_to_apply.ppm = (settings[idx_hw_setup] & mask_ppm) >> flag_ppm;
+    settings_to_apply.bass = (int32_t)((settings[idx_rx_features] & mask_bass) << (28 - flag_bass)) >> 28;
+    settings_to_apply.treble = (int32_t)((settings[idx_rx_features] & mask_treble) << (28 - flag_treble)) >> 28;
+    settings_to_apply.dual_watch = (settings[idx_dual_watch] >> flag_dual_watch_enable) & 1;
+    settings_to_apply.dual_watch_offset_Hz = 100 * (int8_t)((settings[idx_dual_watch] & mask_dual_watch_offset) >> flag_dual_watch_offset);
+    settings_to_apply.dual_watch_mode = (settings[idx_dual_watch] & mask_dual_watch_mode) >> flag_dual_watch_mode;
+    settings_to_apply.wideband_spectrum = (settings[idx_bandwidth_spectrum] >> flag_wideband_spectrum) & 1;
+    settings_to_apply.spectrum_calibrated = (settings[idx_bandwidth_spectrum] >> flag_spectrum_calibrated) & 1;
+    settings_to_apply.spectrum_average = (settings[idx_bandwidth_spectrum] & mask_spectrum_average) >> flag_spectrum_average;
+    settings_to_apply.spectrum_zoom = (settings[idx_bandwidth_spectrum] & mask_spectrum) >> flag_spectrum;
+    settings_to_apply.usb_latency = (settings[idx_hw_setup] & mask_usb_latency) >> flag_usb_latency;
+    settings_to_apply.usb_iq = (settings[idx_hw_setup] >> flag_usb_iq) & 1;
+    receiver.release();
+}
 
-    } else if (strncmp(cmd, "IF", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("IF%011lu00000+0000000000%c0000000;", settings[idx_frequency], mode_translation[settings[idx_mode]]);
-        }
+void process_cat_control(rx_settings & settings_to_apply, rx_status & status, rx &receiver, uint32_t settings[], task_scheduler &scheduler)
+{
+    //partial command, kept between calls
+    static char command[cat_max_command];
+    static uint8_t command_length = 0;
+    static bool overflow = false;
 
-    //fake TX for now
-    } else if (strncmp(cmd, "ID", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("ID020;");
-        }
-    } else if (strncmp(cmd, "AI", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("AI0;");
-        }
-    } else if (strncmp(cmd, "AG", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("AG0;");
-        }
-    } else if (strncmp(cmd, "XT", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("XT1;");
-        }
-    } else if (strncmp(cmd, "RT", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("RT1;");
-        }
-    } else if (strncmp(cmd, "RC", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("RC;");
-        }
-    } else if (strncmp(cmd, "FL", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("FL0;");
-        }
-    } else if (strncmp(cmd, "PS", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("PS1;");
-        }
-    } else if (strncmp(cmd, "VX", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("VX0;");
-        }
-    } else if (strncmp(cmd, "RS", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("RS0;");
-        }
-    } else if (strncmp(cmd, "FL", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("FL0;");
-        }
-    } else if (strncmp(cmd, "AC", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("AC010;");
-        }
-    } else if (strncmp(cmd, "PR", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("PR0;");
-        }
-    } else if (strncmp(cmd, "NB", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("NB0;");
-        }
-    } else if (strncmp(cmd, "LK", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("LK00;");
-        }
-    } else if (strncmp(cmd, "MG", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("MG000;");
-        }
-    } else if (strncmp(cmd, "PL", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("PL000000;");
-        }
-    } else if (strncmp(cmd, "VD", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("VD0000;");
-        }
-    } else if (strncmp(cmd, "VG", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("VG000;");
-        }
-    } else if (strncmp(cmd, "BC", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("BC0;");
-        }
-    } else if (strncmp(cmd, "ML", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("ML000;");
-        }
-    } else if (strncmp(cmd, "NR", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("NR0;");
-        }
-    } else if (strncmp(cmd, "SD", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("SD0000;");
-        }
-    } else if (strncmp(cmd, "KS", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("KS010;");
-        }
-    } else if (strncmp(cmd, "EX", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("EX000000000;");
-        }
-    } else if (strncmp(cmd, "RL", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("RL00;");
-        }
-    } else if (strncmp(cmd, "SQ", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("SQ0000;");
-        }
-    } else if (strncmp(cmd, "RG", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("RG000;");
-        }
-    } else if (strncmp(cmd, "RM", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("RM10000;");
-        }
-    } else if (strncmp(cmd, "PA", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("PA00;");
-        }
-    } else if (strncmp(cmd, "RA", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("RA0000;");
-        }
-    } else if (strncmp(cmd, "GT", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("GT000;");
-        }
-    } else if (strncmp(cmd, "PC", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("PC005;");
-        }
-    } else if (strncmp(cmd, "FW", 2) == 0) {
-        if (cmd[2] == ';') {
-            printf("FW0000;");
-        }
-    } else if (strncmp(cmd, "TX", 2) == 0) {
-        static uint8_t tx_status = 0;
-
-        // Set or Get TX mode command (TX)
-        if (cmd[2] == ';') {
-            // Get current transmit status
-            printf("TX%d;", tx_status);
-        } else if (cmd[2] == '1') {
-            // Switch to TX mode
-            tx_status = 1;
-        } else if (cmd[2] == '0') {
-            // Switch to RX mode
-            tx_status = 0;
-        } else {
-            // Invalid TX command format
-            stdio_puts_raw("?;");
-        }
+    s_cat_context context = {settings_to_apply, status, receiver, settings, scheduler, nullptr, 0, false};
 
-    } else {
-        // Unknown command
-        stdio_puts_raw("?;");
+    //consume the bytes that have already arrived, never wait for more
+    for(uint8_t i = 0; i < cat_max_bytes; ++i)
+    {
+      const int c = stdio_getchar_timeout_us(0);
+      if(c == PICO_ERROR_TIMEOUT) break;
+
+      if(c != ';')
+      {
+        if(command_length < cat_max_command - 1) command[command_length++] = c;
+        else overflow = true;
+        continue;
+      }
+
+      //complete command, a command that was too long is discarded
+      command[command_length++] = ';';
+      if(overflow) put_error();
+      else dispatch(context, command, command_length);
+      command_length = 0;
+      overflow = false;
+      if(reply_length > cat_max_reply/2) flush_reply();
     }
 
+    //send the replies together
+    flush_reply();
+
     //apply settings to receiver
-    if(settings_changed)
+    if(context.settings_changed)
     {
-      receiver.access(true);
-      settings_to_apply.tuned_frequency_Hz = settings[idx_frequency];
-      settings_to_apply.agc_speed = settings[idx_agc_speed];
-      settings_to_apply.enable_auto_notch = settings[idx_rx_features] >> flag_enable_auto_notch & 1;
-      settings_to_apply.mode = settings[idx_mode];
-      settings_to_apply.volume = settings[idx_volume];
-      settings_to_apply.squelch = settings[idx_squelch];
-      settings_to_apply.step_Hz = step_sizes[settings[idx_step]];
-      settings_to_apply.cw_sidetone_Hz = settings[idx_cw_sidetone]*100;
-      settings_to_apply.gain_cal = settings[idx_gain_cal];
-      settings_to_apply.suspend = false;
-      settings_to_apply.swap_iq = (settings[idx_hw_setup] >> flag_swap_iq) & 1;
-      settings_to_apply.bandwidth = (settings[idx_bandwidth_spectrum] & mask_bandwidth) >> flag_bandwidth;
-      settings_to_apply.deemphasis = (settings[idx_rx_features] & mask_deemphasis) >> flag_deemphasis;
-      settings_to_apply.band_1_limit = ((settings[idx_band1] >> 0) & 0xff);
-      settings_to_apply.band_2_limit = ((settings[idx_band1] >> 8) & 0xff);
-      settings_to_apply.band_3_limit = ((settings[idx_band1] >> 16) & 0xff);
-      settings_to_apply.band_4_limit = ((settings[idx_band1] >> 24) & 0xff);
-      settings_to_apply.band_5_limit = ((settings[idx_band2] >> 0) & 0xff);
-      settings_to_apply.band_6_limit = ((settings[idx_band2] >> 8) & 0xff);
-      settings_to_apply.band_7_limit = ((settings[idx_band2] >> 16) & 0xff);
-      settings_to_apply.ppm = (settings[idx_hw_setup] & mask_ppm) >> flag_ppm;
-      receiver.release();
+      apply_cat_settings(settings_to_apply, receiver, settings);
     }
 
 }
@@ -2,7 +2,8 @@
 #define __cat__
 
 #include "rx.h"
+#include "task_scheduler.h"
 
-void process_cat_control(rx_settings & settings_to_apply, rx_status & status, rx &receiver, uint32_t settings[]);
+void process_cat_control(rx_settings & settings_to_apply, rx_status & status, rx &receiver, uint32_t settings[], task_scheduler &scheduler);
 
 #endif
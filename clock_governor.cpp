@@ -0,0 +1,110 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: clock_governor.cpp
+// description: choose the system clock from DSP load and battery state
+// License: MIT
+//
+
+#include "clock_governor.h"
+#include <cmath>
+
+static double lo_error(uint32_t system_clock_frequency, double lo_frequency_Hz, double &divider)
+{
+  const double ideal_divider = system_clock_frequency/(4.0*lo_frequency_Hz);
+  divider = round(256.0*ideal_divider)/256.0;
+  return fabs(system_clock_frequency/divider - 4.0*lo_frequency_Hz)/4.0;
+}
+
+s_clock_choice choose_system_clock(const uint32_t frequencies[], uint8_t num_frequencies, double tuned_frequency_Hz, uint8_t preference)
+{
+  const double lo_up = tuned_frequency_Hz + 4500.0;
+  const double lo_down = tuned_frequency_Hz - 4500.0;
+
+  //best achievable accuracy sets the tolerance for the other preferences
+  double best_error = 1e9;
+  for(uint8_t idx = 0; idx < num_frequencies; idx++)
+  {
+    double divider;
+    best_error = fmin(best_error, lo_error(frequencies[idx], lo_up, divider));
+    best_error = fmin(best_error, lo_error(frequencies[idx], lo_down, divider));
+  }
+  const double tolerance = preference == clock_most_accurate ? best_error : best_error + clock_lo_accuracy_Hz;
+
+  s_clock_choice choice = {0, 0.0, 0.0};
+  bool found = false;
+  double chosen_error = 1e9;
+  const double lo_frequencies[] = {lo_up, lo_down};
+  for(uint8_t idx = 0; idx < num_frequencies; idx++)
+  {
+    for(uint8_t side = 0; side < 2; side++)
+    {
+      double divider;
+      const double error = lo_error(frequencies[idx], lo_frequencies[side], divider);
+      if(error > tolerance) continue;
+
+      bool better = !found;
+      if(found && preference == clock_low_power) better = frequencies[idx] < frequencies[choice.index];
+      if(found && preference == clock_high_performance) better = frequencies[idx] > frequencies[choice.index];
+      if(found && preference == clock_most_accurate) better = error < chosen_error;
+      if(better)
+      {
+        found = true;
+        chosen_error = error;
+        choice.index = idx;
+        choice.divider = divider;
+        choice.lo_frequency_Hz = frequencies[idx]/(4.0*divider);
+      }
+    }
+  }
+  return choice;
+}
+
+bool clock_governor::update(uint32_t busy_time_us, uint32_t block_time_us, uint16_t battery_mV, bool heavy_features, uint32_t time_ms)
+{
+  //smooth the load, one update per block
+  const uint32_t load_sample = block_time_us ? (100u * 16u * busy_time_us) / block_time_us : 0u;
+  load = load - (load >> 4) + (load_sample >> 4);
+  const uint32_t load_percent = load >> 4;
+
+  //usb power holds VSYS near 5V, a battery sits below it
+  const uint16_t on_battery_mV = 4600u;
+  const bool on_battery = battery_mV < on_battery_mV;
+
+  //hysteresis between the thresholds avoids hunting, every change costs a retune
+  uint8_t new_preference = preference;
+  if(load_percent >= 80u || (heavy_features && load_percent >= 60u))
+  {
+    new_preference = clock_high_performance;
+  }
+  else if(on_battery && !heavy_features && load_percent < 50u)
+  {
+    new_preference = clock_low_power;
+  }
+  else if(load_percent < 65u && (preference == clock_high_performance || !on_battery))
+  {
+    new_preference = clock_most_accurate;
+  }
+
+  //overload is handled straight away, relaxing waits for a minimum dwell
+  const uint32_t dwell_ms = 30000u;
+  const bool urgent = new_preference == clock_high_performance;
+  if(new_preference == preference) return false;
+  if(!urgent && (time_ms - last_change_ms) < dwell_ms) return false;
+
+  preference = new_preference;
+  last_change_ms = time_ms;
+  s_governor_decision &decision = decisions[num_decisions % governor_log_size];
+  decision.time_ms = time_ms;
+  decision.load_percent = load_percent > 255u ? 255u : load_percent;
+  decision.battery_mV = battery_mV;
+  decision.heavy_features = heavy_features;
+  decision.preference = preference;
+  num_decisions++;
+  return true;
+}
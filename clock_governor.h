@@ -0,0 +1,71 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: clock_governor.h
+// description: choose the system clock from DSP load and battery state
+// License: MIT
+//
+
+#ifndef CLOCK_GOVERNOR_H
+#define CLOCK_GOVERNOR_H
+#include <stdint.h>
+
+enum e_clock_preference
+{
+  clock_most_accurate,    //closest LO to the target, ignores load
+  clock_low_power,        //slowest clock that meets the LO accuracy target
+  clock_high_performance, //fastest clock that meets the LO accuracy target
+};
+
+//any clock within this distance of the best achievable LO is acceptable,
+//the remaining offset is removed by the digital frequency shift
+static const double clock_lo_accuracy_Hz = 500.0;
+
+struct s_clock_choice
+{
+  uint8_t index;
+  double divider;
+  double lo_frequency_Hz;
+};
+
+//The LO is placed 4.5kHz above or below the tuned frequency, the PIO runs at
+//4x the LO frequency from the system clock with an 8 bit fractional divider.
+s_clock_choice choose_system_clock(const uint32_t frequencies[], uint8_t num_frequencies, double tuned_frequency_Hz, uint8_t preference);
+
+struct s_governor_decision
+{
+  uint32_t time_ms;
+  uint8_t load_percent;
+  uint16_t battery_mV;
+  bool heavy_features;
+  uint8_t preference;
+};
+
+static const uint8_t governor_log_size = 8u;
+
+class clock_governor
+{
+  uint8_t preference = clock_most_accurate;
+  uint32_t load = 0; //percent, 4 fractional bits
+  uint32_t last_change_ms = 0;
+  uint32_t num_decisions = 0;
+  s_governor_decision decisions[governor_log_size];
+
+  public:
+  //busy and block times in us, returns true when the preference changes
+  //(the receiver must be retuned to apply it)
+  bool update(uint32_t busy_time_us, uint32_t block_time_us, uint16_t battery_mV, bool heavy_features, uint32_t time_ms);
+  uint8_t get_preference(){return preference;}
+  uint8_t get_load_percent(){return load >> 4;}
+
+  //decisions are logged oldest first, the last governor_log_size are kept
+  uint32_t get_num_decisions(){return num_decisions;}
+  const s_governor_decision &get_decision(uint32_t n){return decisions[n % governor_log_size];}
+};
+
+#endif
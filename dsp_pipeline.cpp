@@ -0,0 +1,121 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: dsp_pipeline.cpp
+// description: hands decimated IQ blocks from core 1 to core 0
+// License: MIT
+//
+
+#include "dsp_pipeline.h"
+
+#ifndef SIMULATION
+#include "pico/multicore.h"
+#include "hardware/sync.h"
+#else
+static inline void __dmb(){}
+#endif
+
+dsp_pipeline::dsp_pipeline()
+{
+  head = 0;
+  tail = 0;
+  discard = 0;
+  running = false;
+  consumer_busy = false;
+  overflows = 0;
+}
+
+void dsp_pipeline::start()
+{
+  running = true;
+  __dmb();
+}
+
+void dsp_pipeline::stop()
+{
+  running = false;
+  __dmb();
+  while(consumer_busy);
+
+  //the consumer can't start again until running is set, it skips the
+  //queued blocks itself so that each side only writes its own index
+  discard = head;
+  __dmb();
+}
+
+#ifndef SIMULATION
+s_pipeline_block * __not_in_flash_func(dsp_pipeline::get_write_block)()
+#else
+s_pipeline_block * dsp_pipeline::get_write_block()
+#endif
+{
+  //discarded blocks are free even if the consumer hasn't skipped them yet
+  const uint32_t oldest = (int32_t)(discard - tail) > 0 ? discard : tail;
+  if(head - oldest >= dsp_pipeline_depth)
+  {
+    overflows++;
+    return 0;
+  }
+  return &blocks[head & (dsp_pipeline_depth - 1u)];
+}
+
+#ifndef SIMULATION
+void __not_in_flash_func(dsp_pipeline::commit_write_block)()
+#else
+void dsp_pipeline::commit_write_block()
+#endif
+{
+  //block contents must be visible before the index moves
+  __dmb();
+  head = head + 1;
+
+  #ifndef SIMULATION
+  //doorbell, raises the SIO FIFO irq that runs the consumer on core 0
+  multicore_fifo_push_timeout_us(head, 0);
+  #endif
+}
+
+#ifndef SIMULATION
+s_pipeline_block * __not_in_flash_func(dsp_pipeline::get_read_block)()
+#else
+s_pipeline_block * dsp_pipeline::get_read_block()
+#endif
+{
+  #ifndef SIMULATION
+  //discard doorbells, the indices are authoritative
+  while(multicore_fifo_rvalid()) (void)multicore_fifo_pop_blocking();
+  #endif
+
+  //flag busy before checking running, stop() does the reverse
+  consumer_busy = true;
+  __dmb();
+  if(!running)
+  {
+    consumer_busy = false;
+    return 0;
+  }
+  if((int32_t)(discard - tail) > 0) tail = discard;
+  if(head == tail)
+  {
+    consumer_busy = false;
+    return 0;
+  }
+  __dmb();
+  return &blocks[tail & (dsp_pipeline_depth - 1u)];
+}
+
+#ifndef SIMULATION
+void __not_in_flash_func(dsp_pipeline::release_read_block)()
+#else
+void dsp_pipeline::release_read_block()
+#endif
+{
+  __dmb();
+  tail = tail + 1;
+  consumer_busy = false;
+}
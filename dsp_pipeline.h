@@ -0,0 +1,59 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: dsp_pipeline.h
+// description: hands decimated IQ blocks from core 1 to core 0
+// License: MIT
+//
+
+#ifndef DSP_PIPELINE_H
+#define DSP_PIPELINE_H
+#include <stdint.h>
+#include "rx_definitions.h"
+
+//decimated IQ samples per adc block
+static const uint16_t dsp_pipeline_block_size = adc_block_size/cic_decimation_rate;
+static const uint8_t dsp_pipeline_depth = 4u; //power of 2
+
+struct s_pipeline_block
+{
+  uint32_t sequence; //adc block count when captured
+  int16_t real[dsp_pipeline_block_size];
+  int16_t imag[dsp_pipeline_block_size];
+};
+
+//Single producer (core 1) single consumer (core 0) queue. Each side only
+//writes its own index. Core 1 also pushes a doorbell into the SIO FIFO, the
+//FIFO is shared with multicore lockout so the words carry no data and are
+//only used to raise the FIFO irq on core 0.
+class dsp_pipeline
+{
+  s_pipeline_block blocks[dsp_pipeline_depth];
+  volatile uint32_t head;
+  volatile uint32_t tail;
+  volatile uint32_t discard; //producer, blocks before this are skipped by the consumer
+  volatile bool running;
+  volatile bool consumer_busy;
+  uint32_t overflows;
+
+  public:
+  dsp_pipeline();
+
+  //producer, core 1
+  void start();
+  void stop(); //waits until the consumer is idle, queued blocks are discarded
+  s_pipeline_block *get_write_block(); //NULL when full
+  void commit_write_block();
+  uint32_t get_overflows(){return overflows;}
+
+  //consumer, core 0
+  s_pipeline_block *get_read_block(); //NULL when empty or stopped
+  void release_read_block();
+};
+
+#endif
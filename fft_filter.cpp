@@ -23,6 +23,13 @@
 #include "pico/stdlib.h"
 #endif
 
+//The minimum of several noise groups sits below their mean. Expected
+//mean/minimum for gaussian noise, indexed by the number of groups, 8
+//fractional bits. Measured with simulations/test_squelch.py, odd counts
+//interpolated.
+static const uint16_t noise_min_bias[] = {256, 256, 301, 323, 340, 352, 363, 371, 379, 388, 396, 402,
+                                          409, 413, 417, 421, 425, 429, 433, 436, 440, 441, 443};
+
 static int16_t cic_correct(int16_t fft_bin, int16_t fft_offset, int16_t sample)
 {
   int16_t corrected_fft_bin = (fft_bin + fft_offset);
@@ -34,9 +41,11 @@ static int16_t cic_correct(int16_t fft_bin, int16_t fft_offset, int16_t sample)
 }
 
 #ifndef SIMULATION
-void __not_in_flash_func(fft_filter::filter_block)(int16_t sample_real[], int16_t sample_imag[], s_filter_control &filter_control, int16_t capture[]) {
+void __not_in_flash_func(fft_filter::filter_block)(int16_t sample_real[], int16_t sample_imag[], s_filter_control &filter_control, int16_t capture[],
+                                                   int16_t second_real[], int16_t second_imag[], s_filter_control *second_filter_control) {
 #else
-void fft_filter::filter_block(int16_t sample_real[], int16_t sample_imag[], s_filter_control &filter_control, int16_t capture[]) {
+void fft_filter::filter_block(int16_t sample_real[], int16_t sample_imag[], s_filter_control &filter_control, int16_t capture[],
+                                                   int16_t second_real[], int16_t second_imag[], s_filter_control *second_filter_control) {
 #endif
 
   // window
@@ -48,13 +57,76 @@ void fft_filter::filter_block(int16_t sample_real[], int16_t sample_imag[], s_fi
   // forward FFT
   fixed_fft(sample_real, sample_imag, 8);
 
+  //measure in-band signal and out-of-band noise floor (for SNR squelch)
+  //The noise floor uses minimum statistics, the out-of-band bins are split
+  //into groups and the quietest group is taken so that nearby signals
+  //don't raise the estimate, then scaled up by the expected bias of the
+  //minimum. Only done on capture frames, which come at a fixed rate
+  //whatever the block size.
+  const uint8_t noise_guard_bins = 8u;
+  const uint8_t noise_max_bin = 96u; //CIC roll-off is too steep beyond this
+  const uint8_t noise_group_size = 8u;
+  uint32_t signal_sum = 0u;
+  uint16_t signal_bins = 0u;
+  uint32_t noise_group_sum = 0u;
+  uint8_t noise_group_count = 0u;
+  uint32_t noise_min = UINT32_MAX;
+  uint8_t noise_groups = 0u;
   if(filter_control.capture)
   {
     for (uint16_t i = 0; i < fft_size; i++) {
-      capture[i] = (((int32_t)capture[i]<<3) - capture[i] + rectangular_2_magnitude(sample_real[i], sample_imag[i])) >> 3;
+      const uint16_t magnitude = rectangular_2_magnitude(sample_real[i], sample_imag[i]);
+      capture[i] = magnitude;
+
+      //compensate CIC droop so that in and out of band levels compare
+      const int16_t bin = i < fft_size/2 ? i : i - fft_size;
+      int16_t corrected_bin = bin + filter_control.fft_bin;
+      if(corrected_bin > 127) corrected_bin -= 256;
+      if(corrected_bin < -128) corrected_bin += 256;
+      const uint32_t corrected = ((uint32_t)magnitude * cic_correction[abs(corrected_bin)]) >> 8;
+
+      const uint16_t abs_bin = abs(bin);
+      const bool sideband = bin >= 0 ? filter_control.upper_sideband : filter_control.lower_sideband;
+      if(sideband && abs_bin >= filter_control.start_bin && abs_bin <= filter_control.stop_bin)
+      {
+        signal_sum += corrected;
+        signal_bins++;
+      }
+
+      if(abs_bin >= filter_control.stop_bin + noise_guard_bins && abs_bin <= noise_max_bin)
+      {
+        noise_group_sum += corrected;
+        if(++noise_group_count == noise_group_size)
+        {
+          noise_min = std::min(noise_min, noise_group_sum);
+          noise_groups++;
+          noise_group_sum = 0u;
+          noise_group_count = 0u;
+        }
+      }
+      else
+      {
+        noise_group_sum = 0u;
+        noise_group_count = 0u;
+      }
+    }
+    filter_control.signal_level = signal_bins ? signal_sum/signal_bins : 0u;
+
+    //without any out-of-band groups (very wide pass band) hold the last estimate
+    if(noise_groups)
+    {
+      const uint8_t bias_index = std::min(noise_groups, (uint8_t)(sizeof(noise_min_bias)/sizeof(noise_min_bias[0]) - 1u));
+      const uint32_t noise_mean = ((uint64_t)noise_min * noise_min_bias[bias_index]) >> 8;
+      filter_control.noise_level = std::min(noise_mean/noise_group_size, (uint32_t)UINT16_MAX);
     }
   }
 
+  //second channel must be extracted before the spectrum is masked in place
+  if(second_filter_control)
+  {
+    filter_second_channel(sample_real, sample_imag, second_real, second_imag, filter_control, *second_filter_control);
+  }
+
   //largest bin
   int16_t peak = 0;
   int16_t next_peak = 0;
@@ -120,8 +192,6 @@ void fft_filter::filter_block(int16_t sample_real[], int16_t sample_imag[], s_fi
   {
     //check for a consistent
     const uint8_t confirm_threshold = 255u;
-    static uint8_t confirm_count = 0u;
-    static uint8_t last_peak_bin = 0u;
     if(peak_bin == last_peak_bin && confirm_count < confirm_threshold) confirm_count++;
     if(peak_bin != last_peak_bin && confirm_count > 0) confirm_count--;
     last_peak_bin = peak_bin;
@@ -145,32 +215,128 @@ void fft_filter::filter_block(int16_t sample_real[], int16_t sample_imag[], s_fi
 }
 
 
+//Copy the pass band of the second channel from the full spectrum into a half
+//size spectrum centred on DC, then inverse transform.
+#ifndef SIMULATION
+void __not_in_flash_func(fft_filter::filter_second_channel)(const int16_t sample_real[], const int16_t sample_imag[], int16_t second_real[], int16_t second_imag[],
+                                                            const s_filter_control &filter_control, s_filter_control &second_filter_control) {
+#else
+void fft_filter::filter_second_channel(const int16_t sample_real[], const int16_t sample_imag[], int16_t second_real[], int16_t second_imag[],
+                                       const s_filter_control &filter_control, s_filter_control &second_filter_control) {
+#endif
+
+  const int16_t bin_shift = second_filter_control.fft_bin - filter_control.fft_bin;
+  uint32_t signal_sum = 0u;
+  uint16_t signal_bins = 0u;
+  for (int16_t bin = 1 - (int16_t)(new_fft_size/2u); bin <= (int16_t)(new_fft_size/2u); bin++) {
+    const uint16_t dst = bin & (new_fft_size - 1u);
+    const uint16_t src = (bin + bin_shift) & (fft_size - 1u);
+    const uint16_t abs_bin = abs(bin);
+    const bool sideband = bin >= 0 ? second_filter_control.upper_sideband : second_filter_control.lower_sideband;
+    if(sideband && abs_bin >= second_filter_control.start_bin && abs_bin <= second_filter_control.stop_bin)
+    {
+      second_real[dst] = cic_correct(bin, second_filter_control.fft_bin, sample_real[src]);
+      second_imag[dst] = cic_correct(bin, second_filter_control.fft_bin, sample_imag[src]);
+      signal_sum += rectangular_2_magnitude(second_real[dst], second_imag[dst]);
+      signal_bins++;
+    }
+    else
+    {
+      second_real[dst] = 0;
+      second_imag[dst] = 0;
+    }
+  }
+  second_filter_control.signal_level = signal_bins ? signal_sum/signal_bins : 0u;
+  second_filter_control.noise_level = filter_control.noise_level;
+
+  fixed_ifft(second_real, second_imag, 7);
+}
+
+//Shifting by whole bins mixes each frame as if it started at time 0, so the
+//mixer restarts every hop. Rotate each frame by the mixer phase at its start
+//so the second channel is continuous, otherwise any shift that isn't a
+//multiple of fft_size/fft_hop_size cancels or modulates in the overlap-add.
+#ifndef SIMULATION
+void __not_in_flash_func(fft_filter::rotate_second_channel)(int16_t second_real[], int16_t second_imag[], int16_t bin_shift) {
+#else
+void fft_filter::rotate_second_channel(int16_t second_real[], int16_t second_imag[], int16_t bin_shift) {
+#endif
+
+  if(second_phase)
+  {
+    //exp(-j*2*pi*second_phase/fft_size)
+    const uint16_t index = second_phase * (2048u/fft_size);
+    const int32_t rotation_i = sin_table[(index + 512u) & 0x7ffu];
+    const int32_t rotation_q = -sin_table[index];
+    for (uint16_t i = 0; i < new_fft_size; i++) {
+      const int16_t real = second_real[i];
+      const int16_t imag = second_imag[i];
+      second_real[i] = (real * rotation_i - imag * rotation_q) >> 15;
+      second_imag[i] = (imag * rotation_i + real * rotation_q) >> 15;
+    }
+  }
+  second_phase = (second_phase + bin_shift * fft_hop_size) & (fft_size - 1u);
+}
+
+//Each filtered block overlaps the next new_fft_size/new_fft_hop_size blocks,
+//output the completed samples and keep the rest for later blocks.
 #ifndef SIMULATION
-void __not_in_flash_func(fft_filter::process_sample)(int16_t sample_real[], int16_t sample_imag[], s_filter_control &filter_control, int16_t capture[]) {
+void __not_in_flash_func(fft_filter::overlap_add)(const int16_t block_real[], const int16_t block_imag[], int16_t output_real[], int16_t output_imag[],
+                                                  int16_t last_real[], int16_t last_imag[]) {
 #else
-void fft_filter::process_sample(int16_t sample_real[], int16_t sample_imag[], s_filter_control &filter_control, int16_t capture[]) {
+void fft_filter::overlap_add(const int16_t block_real[], const int16_t block_imag[], int16_t output_real[], int16_t output_imag[],
+                             int16_t last_real[], int16_t last_imag[]) {
+#endif
+
+  const uint16_t overlap = new_fft_size - new_fft_hop_size;
+  for (uint16_t i = 0; i < new_fft_hop_size; i++) {
+    output_real[i] = (block_real[i] >> fft_overlap_shift) + last_real[i];
+    output_imag[i] = (block_imag[i] >> fft_overlap_shift) + last_imag[i];
+  }
+  for (uint16_t i = 0; i < overlap; i++) {
+    const uint16_t src = i + new_fft_hop_size;
+    last_real[i] = (src < overlap ? last_real[src] : 0) + (block_real[src] >> fft_overlap_shift);
+    last_imag[i] = (src < overlap ? last_imag[src] : 0) + (block_imag[src] >> fft_overlap_shift);
+  }
+}
+
+#ifndef SIMULATION
+void __not_in_flash_func(fft_filter::process_sample)(int16_t sample_real[], int16_t sample_imag[], s_filter_control &filter_control, int16_t capture[],
+                                                   int16_t second_real[], int16_t second_imag[], s_filter_control *second_filter_control) {
+#else
+void fft_filter::process_sample(int16_t sample_real[], int16_t sample_imag[], s_filter_control &filter_control, int16_t capture[],
+                                                   int16_t second_real[], int16_t second_imag[], s_filter_control *second_filter_control) {
 #endif
 
   int16_t real[fft_size];
   int16_t imag[fft_size];
+  int16_t second_block_real[new_fft_size];
+  int16_t second_block_imag[new_fft_size];
 
-  for (uint16_t i = 0; i < (fft_size/2u); i++) {
+  //combine new samples with the tail of earlier ones
+  const uint16_t history = fft_size - fft_hop_size;
+  for (uint16_t i = 0; i < history; i++) {
     real[i] = last_input_real[i];
     imag[i] = last_input_imag[i];
-    real[fft_size/2u + i] = sample_real[i];
-    imag[fft_size/2u + i] = sample_imag[i];
-    last_input_real[i] = sample_real[i];
-    last_input_imag[i] = sample_imag[i];
+  }
+  for (uint16_t i = 0; i < fft_hop_size; i++) {
+    real[history + i] = sample_real[i];
+    imag[history + i] = sample_imag[i];
+  }
+  for (uint16_t i = 0; i < history; i++) {
+    last_input_real[i] = real[fft_hop_size + i];
+    last_input_imag[i] = imag[fft_hop_size + i];
   }
 
   //filter combined block
-  filter_block(real, imag, filter_control, capture);
+  filter_block(real, imag, filter_control, capture, second_block_real, second_block_imag, second_filter_control);
+
+  overlap_add(real, imag, sample_real, sample_imag, last_output_real, last_output_imag);
 
-  for (uint16_t i = 0; i < (new_fft_size/2u); i++) {
-    sample_real[i] = real[i] + last_output_real[i];
-    sample_imag[i] = imag[i] + last_output_imag[i];
-    last_output_real[i] = real[new_fft_size/2u + i];
-    last_output_imag[i] = imag[new_fft_size/2u + i];
+  if(second_filter_control)
+  {
+    rotate_second_channel(second_block_real, second_block_imag, second_filter_control->fft_bin - filter_control.fft_bin);
+    overlap_add(second_block_real, second_block_imag, second_real, second_imag, last_second_output_real, last_second_output_imag);
   }
 
 }
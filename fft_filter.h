@@ -17,10 +17,17 @@
 #include <cmath>
 
 #include "fft.h"
+#include "rx_definitions.h"
 
 static const uint16_t fft_size = 256;
 static const uint16_t new_fft_size = fft_size/2; 
 
+//new input samples per call, follows the adc block size (128 for 2048)
+static const uint16_t fft_hop_size = adc_block_size/cic_decimation_rate;
+static const uint16_t new_fft_hop_size = fft_hop_size/2;
+//hann windows overlap-add to unity at 50% overlap, scale down for more overlap
+static const uint8_t fft_overlap_shift = fft_hop_size == 128u ? 0u : fft_hop_size == 64u ? 1u : 2u;
+
 struct s_filter_control
 {
   uint16_t start_bin; 
@@ -30,17 +37,36 @@ struct s_filter_control
   bool upper_sideband; 
   bool capture;
   bool enable_auto_notch;
+
+  //measured by filter_block, average magnitude per bin
+  uint16_t signal_level; //inside the pass band
+  uint16_t noise_level;  //quietest group of bins outside the pass band
 };
 
 class fft_filter
 {
 
-  int16_t last_input_real[fft_size/2u];
-  int16_t last_input_imag[fft_size/2u];
-  int16_t last_output_real[new_fft_size/2];
-  int16_t last_output_imag[new_fft_size/2];
+  int16_t last_input_real[fft_size - fft_hop_size];
+  int16_t last_input_imag[fft_size - fft_hop_size];
+  int16_t last_output_real[new_fft_size - new_fft_hop_size];
+  int16_t last_output_imag[new_fft_size - new_fft_hop_size];
+  int16_t last_second_output_real[new_fft_size - new_fft_hop_size];
+  int16_t last_second_output_imag[new_fft_size - new_fft_hop_size];
+  uint16_t second_phase; //start of the frame in the second channel mixer, 1/fft_size cycles
+
+  void overlap_add(const int16_t block_real[], const int16_t block_imag[], int16_t output_real[], int16_t output_imag[],
+                   int16_t last_real[], int16_t last_imag[]);
   int32_t window[fft_size];
-  void filter_block(int16_t sample_real[], int16_t sample_imag[], s_filter_control &filter_control, int16_t capture[]);
+
+  //auto notch
+  uint8_t confirm_count;
+  uint8_t last_peak_bin;
+
+  void filter_block(int16_t sample_real[], int16_t sample_imag[], s_filter_control &filter_control, int16_t capture[],
+                    int16_t second_real[], int16_t second_imag[], s_filter_control *second_filter_control);
+  void filter_second_channel(const int16_t sample_real[], const int16_t sample_imag[], int16_t second_real[], int16_t second_imag[],
+                    const s_filter_control &filter_control, s_filter_control &second_filter_control);
+  void rotate_second_channel(int16_t second_real[], int16_t second_imag[], int16_t bin_shift);
 
   public:
   fft_filter()
@@ -50,16 +76,31 @@ class fft_filter
       float multiplier = 0.5 * (1 - cosf(2*M_PI*i/fft_size));
       window[i] = float2fixed(multiplier);
     }
-    for (uint16_t i = 0; i < fft_size/2u; i++) {
+    reset();
+  }
+  void reset()
+  {
+    for (uint16_t i = 0; i < fft_size - fft_hop_size; i++) {
       last_input_real[i] = 0;
       last_input_imag[i] = 0;
     }
-    for (uint16_t i = 0; i < new_fft_size/2; i++) {
+    for (uint16_t i = 0; i < new_fft_size - new_fft_hop_size; i++) {
       last_output_real[i] = 0;
       last_output_imag[i] = 0;
+      last_second_output_real[i] = 0;
+      last_second_output_imag[i] = 0;
     }
+    second_phase = 0u;
+    confirm_count = 0u;
+    last_peak_bin = 0u;
   }
-  void process_sample(int16_t sample_real[], int16_t sample_imag[], s_filter_control &filter_control, int16_t capture[]);
+
+  //An optional second channel can be filtered from the same forward FFT,
+  //its pass band is centred second_filter_control.fft_bin - filter_control.fft_bin
+  //bins away from the main channel. Each call takes fft_hop_size samples and
+  //returns new_fft_hop_size samples in sample_real/imag and second_real/imag.
+  void process_sample(int16_t sample_real[], int16_t sample_imag[], s_filter_control &filter_control, int16_t capture[],
+                      int16_t second_real[] = nullptr, int16_t second_imag[] = nullptr, s_filter_control *second_filter_control = nullptr);
 
 };
 
@@ -5,7 +5,7 @@
 #include "pico/stdlib.h"
 #include <cmath>
 
-float nco_set_frequency(PIO pio, uint sm, float tuned_frequency, uint32_t &system_clock_frequency_out) {
+float nco_set_frequency(PIO pio, uint sm, float tuned_frequency, uint32_t &system_clock_frequency_out, uint8_t clock_preference) {
 
     //We can get closer to the derired frequency if we allow small adjustments
     //to the system clock. system clocks in the range 125 - 133 MHz are fast
@@ -149,53 +149,24 @@ float nco_set_frequency(PIO pio, uint sm, float tuned_frequency, uint32_t &syste
 
     };
 
-    double adjusted_frequency_up = tuned_frequency + 4500.0;
-    double adjusted_frequency_down = tuned_frequency - 4500.0;
-    PLLSettings best_settings = {0};
-    double best_frequency = 1.0;
-    double best_divider = 0.0;
-    double best_error = 1000000.0;
-
-    for(uint8_t idx = 0; idx < sizeof(possible_frequencies)/sizeof(PLLSettings); idx++)
+    //choose from the clocks that meet the LO accuracy target
+    const uint8_t num_frequencies = sizeof(possible_frequencies)/sizeof(PLLSettings);
+    uint32_t frequencies[num_frequencies];
+    for(uint8_t idx = 0; idx < num_frequencies; idx++)
     {
-
-      uint32_t system_clock_frequency = possible_frequencies[idx].frequency;
-
-      double ideal_divider = system_clock_frequency/(4.0*adjusted_frequency_up);
-      double nearest_divider = round(256.0*ideal_divider)/256.0;
-      double actual_frequency = system_clock_frequency/nearest_divider;
-      double error = abs(actual_frequency - 4.0*adjusted_frequency_up);
-      if(error < best_error)
-      {
-        best_frequency = actual_frequency;
-        best_settings = possible_frequencies[idx];
-        best_divider = nearest_divider;
-        best_error = error;
-        system_clock_frequency_out = system_clock_frequency;
-      }
-
-      ideal_divider = system_clock_frequency/(4.0*adjusted_frequency_down);
-      nearest_divider = round(256.0*ideal_divider)/256.0;
-      actual_frequency = system_clock_frequency/nearest_divider;
-      error = abs(actual_frequency - 4.0*adjusted_frequency_down);
-      if(error < best_error)
-      {
-        best_frequency = actual_frequency;
-        best_settings = possible_frequencies[idx];
-        best_divider = nearest_divider;
-        best_error = error;
-        system_clock_frequency_out = system_clock_frequency;
-      }
+      frequencies[idx] = possible_frequencies[idx].frequency;
     }
+    const s_clock_choice choice = choose_system_clock(frequencies, num_frequencies, tuned_frequency, clock_preference);
+    const PLLSettings best_settings = possible_frequencies[choice.index];
+    system_clock_frequency_out = best_settings.frequency;
 
-    assert(best_error < 1000000);
     //adjust system clock
     uint32_t vco_freq = (12000000 / best_settings.refdiv) * best_settings.fbdiv;
     set_sys_clock_pll(vco_freq, best_settings.postdiv1, best_settings.postdiv2);
 
     //set pio divider
-    pio_sm_set_clkdiv(pio, sm, best_divider);
+    pio_sm_set_clkdiv(pio, sm, choice.divider);
 
     //return actual frequency
-    return best_frequency/4.0;
+    return choice.lo_frequency_Hz;
 }
@@ -1,6 +1,7 @@
 #ifndef NCO_H_
 #define NCO_H_
 #include "hardware/pio.h"
-float nco_set_frequency(PIO pio, uint sm, float tuned_frequency, uint32_t &system_clock_frequency_out);
+#include "clock_governor.h"
+float nco_set_frequency(PIO pio, uint sm, float tuned_frequency, uint32_t &system_clock_frequency_out, uint8_t clock_preference = clock_most_accurate);
 
 #endif
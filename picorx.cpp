@@ -3,15 +3,19 @@
 
 #include "pico/multicore.h"
 #include "pico/time.h"
+#include "hardware/irq.h"
 
 #include "rx.h"
 #include "ui.h"
 #include "waterfall.h"
 #include "cat.h"
+#include "task_scheduler.h"
 
 #define UI_REFRESH_HZ (10UL)
 #define UI_REFRESH_US (1000000UL / UI_REFRESH_HZ)
 #define CAT_REFRESH_US (10000UL)
+#define WATERFALL_REFRESH_US (2000UL)
+#define WATERFALL_BUDGET_US (2000UL) //steps of the waterfall state machine per slot
 
 uint8_t spectrum[256];
 uint8_t dB10=10;
@@ -20,6 +24,7 @@ static rx_status status;
 static rx receiver(settings_to_apply, status);
 waterfall waterfall_inst;
 static ui user_interface(settings_to_apply, status, receiver, spectrum, dB10, waterfall_inst);
+static task_scheduler scheduler;
 
 void core1_main()
 {
@@ -27,6 +32,41 @@ void core1_main()
     receiver.run();
 }
 
+static void ui_task(void *context)
+{
+  user_interface.do_ui();
+  receiver.get_spectrum(spectrum, dB10);
+}
+
+static void cat_task(void *context)
+{
+  process_cat_control(settings_to_apply, status, receiver, user_interface.get_settings(), scheduler);
+}
+
+//A frame is ~360 steps, so one step per slot would limit the display to
+//~11fps. Keep stepping until the budget is used up, the ui and cat tasks
+//run between slots.
+static void waterfall_task(void *context)
+{
+  const uint32_t start = time_us_32();
+  while(waterfall_inst.update_spectrum(receiver, settings_to_apply, status, spectrum, dB10))
+  {
+    if(time_us_32() - start >= WATERFALL_BUDGET_US) break;
+  }
+}
+
+#ifdef DSP_PIPELINE
+//The doorbell from core 1 raises the SIO FIFO irq on core 0. The back end runs
+//in the irq so that it can pre-empt the ui (~25ms per display frame) and meet
+//its one block deadline. multicore_lockout_start_blocking() masks this irq
+//while it uses the FIFO.
+static void __not_in_flash_func(dsp_irq_handler)()
+{
+  multicore_fifo_clear_irq();
+  receiver.service_pipeline();
+}
+#endif
+
 int main() 
 {
   stdio_init_all();
@@ -38,24 +78,15 @@ int main()
   receiver.set_alarm_pool(alarm_pool_create(0, 16));
   user_interface.autorestore();
 
-  uint32_t last_ui_update = 0;
-  uint32_t last_cat_update = 0;
-  while(1)
-  {
-    //schedule tasks
-    if(time_us_32() - last_ui_update > UI_REFRESH_US)
-    {
-      last_ui_update = time_us_32();
-      user_interface.do_ui();
-      receiver.get_spectrum(spectrum, dB10);
-    }
-
-    else if(time_us_32() - last_cat_update > CAT_REFRESH_US)
-    {
-      process_cat_control(settings_to_apply, status, receiver, user_interface.get_settings());
-    }
+  #ifdef DSP_PIPELINE
+  //lowest priority so that the usb irqs and the usb audio alarm pre-empt it
+  irq_set_exclusive_handler(SIO_FIFO_IRQ_NUM(0), dsp_irq_handler);
+  irq_set_priority(SIO_FIFO_IRQ_NUM(0), PICO_LOWEST_IRQ_PRIORITY);
+  irq_set_enabled(SIO_FIFO_IRQ_NUM(0), true);
+  #endif
 
-    waterfall_inst.update_spectrum(receiver, settings_to_apply, status, spectrum, dB10);
-
-  }
+  scheduler.add_task("ui", ui_task, NULL, UI_REFRESH_US, UI_REFRESH_US, 1);
+  scheduler.add_task("cat", cat_task, NULL, CAT_REFRESH_US, CAT_REFRESH_US, 2);
+  scheduler.add_task("waterfall", waterfall_task, NULL, WATERFALL_REFRESH_US, UI_REFRESH_US, 3);
+  scheduler.run();
 }
@@ -0,0 +1,103 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: polyphase_resampler.cpp
+// description: fixed point 16/5 polyphase resampler, 15kHz to 48kHz audio
+// License: MIT
+//
+
+#include "polyphase_resampler.h"
+
+#ifndef SIMULATION
+#include "pico/stdlib.h"
+#endif
+
+//compile time sine, reduced to +/-pi/2 where the series converges quickly
+static constexpr double pi = 3.14159265358979323846;
+static constexpr double constexpr_sin(double x)
+{
+  while(x > pi) x -= 2.0 * pi;
+  while(x < -pi) x += 2.0 * pi;
+  if(x > pi / 2.0) x = pi - x;
+  if(x < -pi / 2.0) x = -pi - x;
+  double term = x;
+  double sum = x;
+  for(int n = 1; n < 12; ++n)
+  {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+static constexpr double constexpr_cos(double x)
+{
+  return constexpr_sin(x + pi / 2.0);
+}
+
+constexpr s_resampler_coefficients::s_resampler_coefficients() : phase()
+{
+  //cutoff relative to the intermediate rate
+  const double cutoff = 0.5 / resampler_interpolation;
+  const double centre = (resampler_taps - 1) / 2.0;
+  const double gain = resampler_interpolation * (1 << resampler_fraction_bits);
+  for(uint16_t n = 0; n < resampler_taps; ++n)
+  {
+    const double t = n - centre;
+    const double sinc = 2.0 * cutoff * constexpr_sin(2.0 * pi * cutoff * t) / (2.0 * pi * cutoff * t);
+    const double w = 2.0 * pi * n / (resampler_taps - 1);
+    const double window = 0.42 - 0.5 * constexpr_cos(w) + 0.08 * constexpr_cos(2.0 * w);
+    const double h = sinc * window * gain;
+    phase[n % resampler_interpolation][n / resampler_interpolation] = h < 0.0 ? h - 0.5 : h + 0.5;
+  }
+}
+
+static constexpr s_resampler_coefficients coefficients;
+
+polyphase_resampler::polyphase_resampler()
+{
+  reset();
+}
+
+void polyphase_resampler::reset()
+{
+  for(uint8_t idx = 0; idx < resampler_taps_per_phase; ++idx) history[idx] = 0;
+  phase = 0;
+}
+
+#ifndef SIMULATION
+uint16_t __not_in_flash_func(polyphase_resampler::process_block)(const int16_t in[], uint16_t num_samples, int16_t out[])
+#else
+uint16_t polyphase_resampler::process_block(const int16_t in[], uint16_t num_samples, int16_t out[])
+#endif
+{
+  uint16_t num_out = 0;
+  for(uint16_t idx = 0; idx < num_samples; ++idx)
+  {
+    for(uint8_t tap = resampler_taps_per_phase - 1; tap > 0; --tap) history[tap] = history[tap - 1];
+    history[0] = in[idx];
+
+    //each input spans 16 intermediate samples, an output is taken every 5th
+    while(phase < resampler_interpolation)
+    {
+      const int16_t *h = coefficients.phase[phase];
+      int32_t accumulator = 1 << (resampler_fraction_bits - 1);
+      for(uint8_t tap = 0; tap < resampler_taps_per_phase; ++tap)
+      {
+        accumulator += (int32_t)h[tap] * history[tap];
+      }
+      accumulator >>= resampler_fraction_bits;
+      accumulator = accumulator > INT16_MAX ? INT16_MAX : accumulator;
+      accumulator = accumulator < INT16_MIN ? INT16_MIN : accumulator;
+      out[num_out++] = accumulator;
+      phase += resampler_decimation;
+    }
+    phase -= resampler_interpolation;
+  }
+  return num_out;
+}
@@ -0,0 +1,47 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: polyphase_resampler.h
+// description: fixed point 16/5 polyphase resampler, 15kHz to 48kHz audio
+// License: MIT
+//
+
+#ifndef POLYPHASE_RESAMPLER_H
+#define POLYPHASE_RESAMPLER_H
+#include <stdint.h>
+
+static const uint8_t resampler_interpolation = 16u;
+static const uint8_t resampler_decimation = 5u;
+static const uint8_t resampler_taps_per_phase = 16u;
+static const uint16_t resampler_taps = resampler_interpolation * resampler_taps_per_phase;
+static const uint8_t resampler_fraction_bits = 14u;
+
+//Prototype low pass at the 240kHz intermediate rate, Blackman windowed sinc
+//with the cutoff at the 7.5kHz input Nyquist frequency. The coefficients
+//are calculated by the compiler and stored by phase so that each output
+//sample reads one contiguous row.
+struct s_resampler_coefficients
+{
+  int16_t phase[resampler_interpolation][resampler_taps_per_phase];
+  constexpr s_resampler_coefficients();
+};
+
+class polyphase_resampler
+{
+  int16_t history[resampler_taps_per_phase]; //newest first
+  uint8_t phase;
+
+  public:
+  polyphase_resampler();
+  void reset();
+
+  //out must hold num_samples*16/5 + 1, returns the number of output samples
+  uint16_t process_block(const int16_t in[], uint16_t num_samples, int16_t out[]);
+};
+
+#endif
@@ -0,0 +1,76 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: pwm_output.cpp
+// description: convert audio samples to PWM levels
+// License: MIT
+//
+
+#include "pwm_output.h"
+
+#ifndef SIMULATION
+#include "pico/stdlib.h"
+#endif
+
+void pwm_output::reset()
+{
+  last_level = 0;
+  integrator = 0;
+  error_1 = 0;
+  error_2 = 0;
+}
+
+#ifndef SIMULATION
+uint16_t __not_in_flash_func(pwm_output::process_sample)(int16_t audio, int16_t pwm[])
+#else
+uint16_t pwm_output::process_sample(int16_t audio, int16_t pwm[])
+#endif
+{
+  //scale to 0 - pwm_max with 16 fractional bits
+  const int32_t level = (uint32_t)(audio + 32768) * pwm_max;
+
+#if defined(PWM_HARDWARE_PACED)
+
+  pwm[0] = level >> 16;
+
+#elif defined(PWM_NOISE_SHAPING)
+
+  //interpolate keeping the fraction, integrator has 20 fractional bits
+  const int32_t comb = level - last_level;
+  last_level = level;
+  for(uint8_t subsample = 0; subsample < interpolation_rate; ++subsample)
+  {
+    integrator += comb;
+
+    //quantisation noise is shaped by (1 - z^-1)^2
+    const int32_t shaped = integrator + 2*error_1 - error_2;
+    int32_t output = shaped >> 20;
+    error_2 = error_1;
+    error_1 = shaped - (output << 20);
+
+    //clipping errors are not fed back, so the loop stays stable
+    if(output < 0) output = 0;
+    if(output > (int32_t)pwm_max) output = pwm_max;
+    pwm[subsample] = output;
+  }
+
+#else
+
+  //interpolate to PWM rate
+  const int32_t comb = (level >> 16) - last_level;
+  last_level = level >> 16;
+  for(uint8_t subsample = 0; subsample < interpolation_rate; ++subsample)
+  {
+    integrator += comb;
+    pwm[subsample] = integrator >> 4;
+  }
+
+#endif
+
+  return pwm_interpolation_rate;
+}
@@ -0,0 +1,39 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: pwm_output.h
+// description: convert audio samples to PWM levels
+// License: MIT
+//
+
+#ifndef PWM_OUTPUT_H
+#define PWM_OUTPUT_H
+#include <stdint.h>
+#include "rx_definitions.h"
+
+//Audio is scaled to the PWM range with a multiply and shift, then
+//interpolated to the PWM rate. With PWM_NOISE_SHAPING the fraction
+//discarded by the PWM is fed back (2nd order error feedback) so that
+//the quantisation noise is pushed above the audio band.
+class pwm_output
+{
+  uint32_t pwm_max = 520u;
+  int32_t last_level = 0;
+  int32_t integrator = 0;
+  int32_t error_1 = 0;
+  int32_t error_2 = 0;
+
+  public:
+  void set_pwm_max(uint32_t max){pwm_max = max;}
+  void reset();
+
+  //writes pwm_interpolation_rate PWM levels, returns the number written
+  uint16_t process_sample(int16_t audio, int16_t pwm[]);
+};
+
+#endif
@@ -1,7 +0,0 @@
-#ifndef __RING_BUFFER_LIB_CONFIG_H__
-#define __RING_BUFFER_LIB_CONFIG_H__
-
-#define RING_BUFFER_SIZE_TYPE uint16_t
-#define RING_BUFFER_MULTICORE_SUPPORT (1)
-
-#endif // __RING_BUFFER_LIB_CONFIG_H__
@@ -9,12 +9,26 @@
 #include "fft_filter.h"
 #include "utils.h"
 #include "usb_audio_device.h"
-#include "ring_buffer_lib.h"
-
-//ring buffer for USB data
-#define USB_BUF_SIZE (sizeof(int16_t) * 2 * (1 + (adc_block_size/decimation_rate)))
-static ring_buffer_t usb_ring_buffer;
-static uint8_t usb_buf[USB_BUF_SIZE];
+#include "audio_ring.h"
+#include "polyphase_resampler.h"
+#include "adc_capture.h"
+
+//ring buffer for USB data, written by the DSP and read by the USB callback,
+//holds interleaved left/right pairs
+static const uint8_t usb_channels = 2u;
+static audio_ring usb_ring;
+static volatile uint32_t usb_underruns = 0;
+
+//The ring fills up while the host isn't streaming. The usb callback drops
+//back to the target level when the stream (re)starts or the dsp reports an
+//overflow, the dsp then restarts the rate matcher.
+static const uint32_t usb_stream_gap_us = 20000u;
+static volatile uint16_t usb_flush_level = 0; //interleaved samples
+static volatile bool usb_flush_requested = false;
+static volatile bool usb_flush_done = false;
+
+//raw adc blocks for the host, copied by core 1 and sent by the usb task
+static adc_capture adc_capture_inst;
 
 //buffers and dma for ADC
 int rx::adc_dma_ping;
@@ -30,11 +44,20 @@ int rx::pwm_dma_ping;
 int rx::pwm_dma_pong;
 dma_channel_config rx::audio_ping_cfg;
 dma_channel_config rx::audio_pong_cfg;
-int16_t rx::ping_audio[adc_block_size];
-int16_t rx::pong_audio[adc_block_size];
+int16_t rx::ping_audio[pwm_block_size];
+int16_t rx::pong_audio[pwm_block_size];
 bool rx::audio_running;
 uint16_t rx::num_ping_samples;
 uint16_t rx::num_pong_samples;
+#ifdef DSP_PIPELINE
+int16_t rx::third_audio[pwm_block_size];
+int16_t * const rx::pipeline_audio[pipeline_audio_buffers] = {ping_audio, pong_audio, third_audio};
+uint16_t rx::num_pipeline_samples[pipeline_audio_buffers];
+#endif
+
+//deadline and overrun telemetry
+volatile uint32_t rx::adc_block_sequence;
+volatile uint32_t rx::irq_late;
 
 //dma for capture
 int rx::capture_dma;
@@ -49,23 +72,46 @@ void rx::dma_handler() {
     // processing pong              ###
     // pwm_ping                     ####
     // pwm_pong                         ####
+    //
+    // With DSP_PIPELINE the back end finishes part way through the next
+    // block, so the three audio buffers rotate and the output of block N
+    // plays as block N+2 completes.
+
+    //both blocks completing before the handler runs means a re-arm was late
+    const uint32_t both = (1u << adc_dma_ping) | (1u << adc_dma_pong);
+    if((dma_hw->ints0 & both) == both)
+    {
+      irq_late++;
+    }
 
     if(dma_hw->ints0 & (1u << adc_dma_ping))
     {
       dma_channel_configure(adc_dma_ping, &ping_cfg, ping_samples, &adc_hw->fifo, adc_block_size, false);
       if(audio_running){
+        #ifdef DSP_PIPELINE
+        const uint8_t play = (adc_block_sequence + 2u) % pipeline_audio_buffers;
+        dma_channel_configure(pwm_dma_pong, &audio_pong_cfg, &pwm_hw->slice[audio_pwm_slice_num].cc, pipeline_audio[play], num_pipeline_samples[play], true);
+        #else
         dma_channel_configure(pwm_dma_pong, &audio_pong_cfg, &pwm_hw->slice[audio_pwm_slice_num].cc, pong_audio, num_pong_samples, true);
+        #endif
       }
+      adc_block_sequence++;
       dma_hw->ints0 = 1u << adc_dma_ping;
     }
 
     if(dma_hw->ints0 & (1u << adc_dma_pong))
     {
       dma_channel_configure(adc_dma_pong, &pong_cfg, pong_samples, &adc_hw->fifo, adc_block_size, false);
+      #ifdef DSP_PIPELINE
+      const uint8_t play = (adc_block_sequence + 2u) % pipeline_audio_buffers;
+      dma_channel_configure(pwm_dma_ping, &audio_ping_cfg, &pwm_hw->slice[audio_pwm_slice_num].cc, pipeline_audio[play], num_pipeline_samples[play], true);
+      #else
       dma_channel_configure(pwm_dma_ping, &audio_ping_cfg, &pwm_hw->slice[audio_pwm_slice_num].cc, ping_audio, num_ping_samples, true);
+      #endif
       if(!audio_running){
         audio_running = true;
       }
+      adc_block_sequence++;
       dma_hw->ints0 = 1u << adc_dma_pong;
     }
 
@@ -128,13 +174,43 @@ void rx::update_status()
 
      //update status
      status.signal_strength_dBm = rx_dsp_inst.get_signal_strength_dBm();
+     status.snr_dB = rx_dsp_inst.get_snr_dB();
+     status.squelch_open = rx_dsp_inst.get_squelch_open();
+     #ifdef DSP_PIPELINE
+     //the busier of the two cores limits the processing budget
+     busy_time = std::max(busy_time, (uint32_t)back_end_time);
+     #endif
      status.busy_time = busy_time;
      status.battery = battery;
      status.temp = temp;
      status.filter_config = rx_dsp_inst.get_filter_config();
-     static uint16_t avg_level = 0;
-     avg_level = (avg_level - (avg_level >> 2)) + (ring_buffer_get_num_bytes(&usb_ring_buffer) >> 2);
-     status.usb_buf_level = 100 * avg_level / USB_BUF_SIZE;
+     rx_dsp_inst.get_spectrum_frame_counts(status.spectrum_frames_published, status.spectrum_frames_dropped);
+     status.adc_blocks = adc_block_sequence;
+     status.blocks_missed = blocks_missed;
+     status.adc_overflows = adc_overflows;
+     status.irq_late = irq_late;
+     status.system_clock_Hz = system_clock_Hz;
+     status.clock_preference = governor.get_preference();
+     status.cpu_load_percent = governor.get_load_percent();
+     status.num_events = num_events;
+     memcpy(status.events, events, sizeof(events));
+     //retune when the governor asks for a different clock
+     const uint32_t block_time_us = (uint64_t)adc_block_size * 1000000u / adc_sample_rate;
+     const uint16_t battery_mV = (uint32_t)battery * 9900u / 65535u;
+     const bool heavy_features = settings_to_apply.dual_watch || settings_to_apply.wideband_spectrum || settings_to_apply.spectrum_zoom > 1;
+     if(governor.update(busy_time, block_time_us, battery_mV, heavy_features, to_ms_since_boot(get_absolute_time())))
+     {
+       settings_changed = true;
+     }
+
+     usb_buf_avg_level = (usb_buf_avg_level - (usb_buf_avg_level >> 2)) + ((usb_ring.get_num_samples()/usb_channels) >> 2);
+     status.usb_buf_level = 100 * usb_buf_avg_level * usb_channels / audio_ring_size;
+     status.usb_underruns = usb_underruns;
+     status.usb_overruns = usb_ring.get_dropped()/usb_channels;
+     status.usb_min_level = usb_reported_min_level;
+     status.usb_max_level = usb_reported_max_level;
+     status.usb_latency_ms = (uint32_t)usb_buf_avg_level * 1000u / (adc_sample_rate/decimation_rate);
+     status.usb_target_latency_ms = usb_latency_ms[usb_latency];
      sem_release(&settings_semaphore);
    }
 }
@@ -144,14 +220,20 @@ void rx::apply_settings()
    if(sem_try_acquire(&settings_semaphore))
    {
 
-      //apply frequency
+      //apply frequency, flush filter and demodulator history after a retune
+      if(requested_frequency_Hz != settings_to_apply.tuned_frequency_Hz)
+      {
+        requested_frequency_Hz = settings_to_apply.tuned_frequency_Hz;
+        rx_dsp_inst.retune();
+      }
       tuned_frequency_Hz = settings_to_apply.tuned_frequency_Hz;
 
       //apply frequency calibration
       tuned_frequency_Hz *= 1e6/(1e6+settings_to_apply.ppm);
 
       uint32_t system_clock_rate;
-      nco_frequency_Hz = nco_set_frequency(pio, sm, tuned_frequency_Hz, system_clock_rate);
+      nco_frequency_Hz = nco_set_frequency(pio, sm, tuned_frequency_Hz, system_clock_rate, governor.get_preference());
+      system_clock_Hz = system_clock_rate;
       offset_frequency_Hz = tuned_frequency_Hz - nco_frequency_Hz;
 
       if(tuned_frequency_Hz > (settings_to_apply.band_7_limit * 125000))
@@ -205,8 +287,11 @@ void rx::apply_settings()
 
       //apply pwm_max
       pwm_max = (system_clock_rate/audio_sample_rate)-1;
-      pwm_scale = 1+((INT16_MAX * 2)/pwm_max);
+      pwm_output_inst.set_pwm_max(pwm_max);
       pwm_set_wrap(audio_pwm_slice_num, pwm_max); 
+#ifdef PWM_HARDWARE_PACED
+      set_pwm_dma_timer(system_clock_rate);
+#endif
 
       //apply frequency offset
       rx_dsp_inst.set_frequency_offset_Hz(offset_frequency_Hz);
@@ -223,9 +308,16 @@ void rx::apply_settings()
       //apply Automatic Notch Filter
       rx_dsp_inst.set_auto_notch(settings_to_apply.enable_auto_notch);
 
-      //apply mode
+      //apply mode, iq output widens the passband
+      usb_iq = settings_to_apply.usb_iq;
+      rx_dsp_inst.set_iq_output(usb_iq);
       rx_dsp_inst.set_mode(settings_to_apply.mode, settings_to_apply.bandwidth);
 
+      //apply dual watch, the second channel uses the same bandwidth setting
+      dual_watch = settings_to_apply.dual_watch;
+      rx_dsp_inst.set_dual_watch(settings_to_apply.dual_watch, settings_to_apply.dual_watch_offset_Hz,
+                                 settings_to_apply.dual_watch_mode, settings_to_apply.bandwidth);
+
       //apply volume
       static const int16_t gain[] = {
         0,   // 0 = 0/256 -infdB
@@ -241,14 +333,26 @@ void rx::apply_settings()
       };
       gain_numerator = gain[settings_to_apply.volume];
 
+      //apply wideband spectrum
+      wideband_spectrum = settings_to_apply.wideband_spectrum;
+      rx_dsp_inst.set_wideband_spectrum(settings_to_apply.wideband_spectrum);
+      rx_dsp_inst.set_spectrum_calibrated(settings_to_apply.spectrum_calibrated);
+      rx_dsp_inst.set_spectrum_average(settings_to_apply.spectrum_average);
+      rx_dsp_inst.set_spectrum_zoom(settings_to_apply.wideband_spectrum ? 1 : settings_to_apply.spectrum_zoom);
+      set_usb_latency(settings_to_apply.usb_latency);
+
       //apply deemphasis
       rx_dsp_inst.set_deemphasis(settings_to_apply.deemphasis);
 
+      //apply tone controls
+      rx_dsp_inst.set_tone(settings_to_apply.bass, settings_to_apply.treble);
+
       //apply squelch
       rx_dsp_inst.set_squelch(settings_to_apply.squelch);
 
       //apply swap iq
       rx_dsp_inst.set_swap_iq(settings_to_apply.swap_iq);
+      adc_capture_inst.set_front_end(nco_frequency_Hz, settings_to_apply.swap_iq);
 
       //apply iq imbalance correction
       rx_dsp_inst.set_iq_correction(settings_to_apply.iq_correction);
@@ -260,7 +364,14 @@ void rx::apply_settings()
 
 void rx::get_spectrum(uint8_t spectrum[], uint8_t &dB10)
 {
-  rx_dsp_inst.get_spectrum(spectrum, dB10);
+  if(wideband_spectrum)
+  {
+    rx_dsp_inst.get_wideband_spectrum(spectrum, dB10);
+  }
+  else
+  {
+    rx_dsp_inst.get_spectrum(spectrum, dB10);
+  }
 }
 
 
@@ -275,7 +386,7 @@ rx::rx(rx_settings & settings_to_apply, rx_status & status) : settings_to_apply(
     offset = pio_add_program(pio, &nco_program);
     sm = pio_claim_unused_sm(pio, true);
     nco_program_init(pio, sm, offset);
-    ring_buffer_init(&usb_ring_buffer, usb_buf, USB_BUF_SIZE, 1);
+    set_usb_latency(0);
 
     //configure SMPS into power save mode
     const uint PSU_PIN = 23;
@@ -344,12 +455,20 @@ rx::rx(rx_settings & settings_to_apply, rx_status & status) : settings_to_apply(
     channel_config_set_transfer_data_size(&audio_ping_cfg, DMA_SIZE_16);
     channel_config_set_read_increment(&audio_ping_cfg, true);
     channel_config_set_write_increment(&audio_ping_cfg, false);
-    channel_config_set_dreq(&audio_ping_cfg, DREQ_PWM_WRAP0 + audio_pwm_slice_num);
+#ifdef PWM_HARDWARE_PACED
+    //a DMA timer paces compare updates at the audio rate, the PWM double
+    //buffers the compare value so each update takes effect at the next wrap
+    pwm_dma_timer = dma_claim_unused_timer(true);
+    const uint pwm_dreq = dma_get_timer_dreq(pwm_dma_timer);
+#else
+    const uint pwm_dreq = DREQ_PWM_WRAP0 + audio_pwm_slice_num;
+#endif
+    channel_config_set_dreq(&audio_ping_cfg, pwm_dreq);
 
     channel_config_set_transfer_data_size(&audio_pong_cfg, DMA_SIZE_16);
     channel_config_set_read_increment(&audio_pong_cfg, true);
     channel_config_set_write_increment(&audio_pong_cfg, false);
-    channel_config_set_dreq(&audio_pong_cfg, DREQ_PWM_WRAP0 + audio_pwm_slice_num);
+    channel_config_set_dreq(&audio_pong_cfg, pwm_dreq);
 
     //configure DMA for audio transfers
     capture_dma = dma_claim_unused_channel(true);
@@ -364,15 +483,46 @@ rx::rx(rx_settings & settings_to_apply, rx_status & status) : settings_to_apply(
 
 }
 
+#ifdef PWM_HARDWARE_PACED
+//The timer runs at system_clock_rate * numerator / denominator, both 16 bits.
+//Pick the closest fraction to the audio rate, the pwm dma is restarted every
+//block so a small error only shifts the last sample of each block.
+void rx::set_pwm_dma_timer(uint32_t system_clock_rate)
+{
+  const uint32_t output_rate = adc_sample_rate/decimation_rate;
+  uint16_t best_numerator = 1;
+  uint16_t best_denominator = UINT16_MAX;
+  uint32_t best_error = UINT32_MAX;
+  for(uint32_t numerator = 1; ; ++numerator)
+  {
+    const uint32_t denominator = ((uint64_t)numerator * system_clock_rate + output_rate/2) / output_rate;
+    if(denominator > UINT16_MAX) break;
+    const uint32_t rate = (uint64_t)numerator * system_clock_rate / denominator;
+    const uint32_t error = rate > output_rate ? rate - output_rate : output_rate - rate;
+    if(error < best_error)
+    {
+      best_error = error;
+      best_numerator = numerator;
+      best_denominator = denominator;
+    }
+  }
+  dma_timer_set_fraction(pwm_dma_timer, best_numerator, best_denominator);
+}
+#endif
+
+//the temperature sensor is the last adc input, ADC4 on RP2040, ADC8 on RP2350B
+static const uint8_t batt_adc_channel = 3u;
+static const uint8_t temp_adc_channel = ADC_TEMPERATURE_CHANNEL_NUM;
+
 void rx::read_batt_temp()
 {
-  adc_select_input(3);
+  adc_select_input(batt_adc_channel);
   battery = 0;
   for(uint8_t i=0; i<16; i++)
   {
     battery += adc_read();
   }
-  adc_select_input(4);
+  adc_select_input(temp_adc_channel);
   temp = 0;
   for(uint8_t i=0; i<16; i++)
   {
@@ -380,9 +530,126 @@ void rx::read_batt_temp()
   }
 }
 
+void __not_in_flash_func(rx::log_event)(uint8_t type)
+{
+  s_rx_event &event = events[num_events % rx_event_log_size];
+  event.time_us = time_us_32();
+  event.sequence = processed_sequence;
+  event.type = type;
+  num_events++;
+}
+
+//Called after each block is processed. If the dma handler has already seen
+//the next block complete, the buffer just processed was being overwritten.
+void __not_in_flash_func(rx::check_deadline)()
+{
+  //The other buffer is processed next whatever happened, so only catch up to
+  //the block before the newest one and let that buffer take the next number.
+  //Signed, a block processed early must not wrap the lag.
+  processed_sequence++;
+  const int32_t lag = (int32_t)(adc_block_sequence - processed_sequence);
+  if(lag > 0)
+  {
+    blocks_missed += lag;
+    processed_sequence += lag - 1;
+    log_event(event_deadline_missed);
+  }
+
+  //fifo overflow means samples were lost before reaching the dma
+  if(adc_hw->fcs & ADC_FCS_OVER_BITS)
+  {
+    hw_set_bits(&adc_hw->fcs, ADC_FCS_OVER_BITS); //write 1 to clear
+    adc_overflows++;
+    log_event(event_adc_overflow);
+  }
+
+  if(irq_late != reported_irq_late)
+  {
+    reported_irq_late = irq_late;
+    log_event(event_irq_late);
+  }
+
+  #ifdef DSP_PIPELINE
+  //core 0 only counts, events are logged here to keep the log single writer
+  if(pipeline.get_overflows() != reported_pipeline_full)
+  {
+    reported_pipeline_full = pipeline.get_overflows();
+    log_event(event_pipeline_full);
+  }
+  if(back_end_late != reported_back_end_late)
+  {
+    reported_back_end_late = back_end_late;
+    log_event(event_back_end_late);
+  }
+  #endif
+}
+
+static inline uint8_t adc_current_input()
+{
+  return (adc_hw->cs & ADC_CS_AINSEL_BITS) >> ADC_CS_AINSEL_LSB;
+}
+
+//the switch normally takes a few 2us conversions
+static const uint32_t batt_temp_timeout_us = 20u;
+
+//false if the round robin doesn't reach input before the timeout
+static inline bool wait_for_adc_input(uint8_t input, uint32_t start_us)
+{
+  while(adc_current_input() != input)
+  {
+    if(time_us_32() - start_us > batt_temp_timeout_us) return false;
+  }
+  return true;
+}
+
+//The round robin briefly includes battery and temperature so that one pair
+//of readings lands in the pong buffer after a Q sample, keeping the I/Q
+//alignment. Returns the index of the battery sample or -1, in which case
+//the telemetry sample is skipped.
+int16_t __not_in_flash_func(rx::insert_batt_temp)()
+{
+  //stay clear of the ends of the buffer so both samples land in pong
+  const uint32_t remaining = dma_channel_hw_addr(adc_dma_pong)->transfer_count;
+  if(remaining < 16 || remaining > adc_block_size - 16) return -1;
+
+  //a conversion takes 2us, switch the round robin while Q is converting
+  int16_t index = -1;
+  const uint32_t interrupts = save_and_disable_interrupts();
+  const uint32_t start_us = time_us_32();
+  if(wait_for_adc_input(1, start_us))
+  {
+    adc_set_round_robin(0x03 | (1u << batt_adc_channel) | (1u << temp_adc_channel));
+    const bool inserted = wait_for_adc_input(temp_adc_channel, start_us);
+    adc_set_round_robin(0x03);
+    if(inserted && wait_for_adc_input(0, start_us))
+    {
+      busy_wait_us_32(1); //wait for the temperature sample to reach memory
+      index = adc_block_size - dma_channel_hw_addr(adc_dma_pong)->transfer_count - 2;
+    }
+  }
+  restore_interrupts(interrupts);
+
+  return index;
+}
+
+//Replace the inserted readings with the preceding I/Q pair before processing
+void __not_in_flash_func(rx::extract_batt_temp)(uint16_t samples[])
+{
+  if(batt_temp_index < 2 || batt_temp_index > adc_block_size - 2) return;
+  const uint16_t battery_sample = samples[batt_temp_index];
+  const uint16_t temp_sample = samples[batt_temp_index + 1];
+  samples[batt_temp_index] = samples[batt_temp_index - 2];
+  samples[batt_temp_index + 1] = samples[batt_temp_index - 1];
+
+  //keep the same scaling as read_batt_temp (sum of 16 readings)
+  battery = battery - (battery >> 4) + battery_sample;
+  temp = temp - (temp >> 4) + temp_sample;
+}
+
 static bool __not_in_flash_func(usb_callback)(repeating_timer_t *rt)
 {
   usb_audio_device_task();
+  adc_capture_inst.service();
   return true; // keep repeating
 }
 
@@ -405,20 +672,106 @@ static void on_usb_set_mutevol(bool mute, int16_t vol)
   critical_section_exit(&usb_volumute);
 }
 
+//the ring holds 15kHz audio, one packet of left/right pairs is taken every 1ms
+static const uint16_t usb_packet_samples = usb_channels * USB_A_SAMPLE_RATE/1000;
+static polyphase_resampler usb_resampler[usb_channels];
+
+static void usb_write_resampled()
+{
+  //copy out one packet, padded with silence on underflow
+  int16_t packet[usb_packet_samples];
+  uint16_t num_samples = 0;
+  while(num_samples < usb_packet_samples)
+  {
+    const int16_t *span;
+    const uint16_t span_samples = std::min(usb_ring.get_read_span(span), (uint16_t)(usb_packet_samples - num_samples));
+    if(!span_samples) break;
+    memcpy(&packet[num_samples], span, span_samples * sizeof(int16_t));
+    usb_ring.consume(span_samples);
+    num_samples += span_samples;
+  }
+  if(num_samples < usb_packet_samples)
+  {
+    usb_underruns = usb_underruns + 1;
+    memset(&packet[num_samples], 0, (usb_packet_samples - num_samples) * sizeof(int16_t));
+  }
+
+  //15 pairs become exactly 48, each channel has its own resampler
+  static const uint16_t packet_pairs = usb_packet_samples/usb_channels;
+  static const uint16_t max_resampled = packet_pairs * resampler_interpolation / resampler_decimation + 1;
+  int16_t channel_in[packet_pairs];
+  int16_t channel_out[max_resampled];
+  int16_t resampled[usb_channels * max_resampled];
+  uint16_t num_resampled = 0;
+  for(uint8_t channel = 0; channel < usb_channels; ++channel)
+  {
+    for(uint16_t idx = 0; idx < packet_pairs; ++idx) channel_in[idx] = packet[usb_channels * idx + channel];
+    num_resampled = usb_resampler[channel].process_block(channel_in, packet_pairs, channel_out);
+    for(uint16_t idx = 0; idx < num_resampled; ++idx) resampled[usb_channels * idx + channel] = channel_out[idx];
+  }
+  usb_audio_device_write(resampled, usb_channels * num_resampled * sizeof(int16_t));
+}
+
+static void flush_stale_usb_audio()
+{
+  static uint32_t last_packet_us = 0;
+  const uint32_t now = time_us_32();
+  if(usb_flush_requested || now - last_packet_us > usb_stream_gap_us)
+  {
+    const uint16_t level = usb_ring.get_num_samples();
+    if(level > usb_flush_level) usb_ring.consume(level - usb_flush_level);
+    usb_flush_requested = false;
+    usb_flush_done = true;
+  }
+  last_packet_us = now;
+}
+
 static void on_usb_audio_tx_ready()
 {
-  uint8_t usb_buf[SAMPLE_BUFFER_SIZE * sizeof(int16_t)] = {0};
+  static const int16_t silence[usb_packet_samples] = {0};
+
+  flush_stale_usb_audio();
 
   // Callback from TinyUSB library when all data is ready
   // to be transmitted.
-  //
-  // Write local buffer to the USB microphone
-  ring_buffer_pop(&usb_ring_buffer, usb_buf, sizeof(usb_buf));
-  usb_audio_device_write(usb_buf, sizeof(usb_buf));
+  if(usb_audio_device_get_sample_rate() == USB_A_HIGH_SAMPLE_RATE)
+  {
+    usb_write_resampled();
+    return;
+  }
+
+  // Write straight from the ring to the USB microphone, the
+  // usb stack copies into its own fifo
+  uint16_t remaining = usb_packet_samples;
+  while(remaining)
+  {
+    const int16_t *span;
+    const uint16_t num_samples = std::min(usb_ring.get_read_span(span), remaining);
+    if(!num_samples) break;
+    usb_audio_device_write(span, num_samples * sizeof(int16_t));
+    usb_ring.consume(num_samples);
+    remaining -= num_samples;
+  }
+
+  //pad with silence on underflow to keep the packet size
+  if(remaining)
+  {
+    usb_underruns = usb_underruns + 1;
+    usb_audio_device_write(silence, remaining * sizeof(int16_t));
+  }
 }
 
 
 uint16_t __not_in_flash_func(rx::process_block)(uint16_t adc_samples[], int16_t pwm_audio[])
+{
+  //process adc IQ samples to produce raw audio (or filtered IQ)
+  int16_t usb_audio[adc_block_size/decimation_rate];
+  int16_t dual_watch_audio[adc_block_size/decimation_rate];
+  uint16_t num_samples = rx_dsp_inst.process_block(adc_samples, usb_audio, dual_watch_audio);
+  return output_audio(usb_audio, dual_watch_audio, num_samples, pwm_audio);
+}
+
+uint16_t __not_in_flash_func(rx::output_audio)(int16_t usb_audio[], const int16_t dual_watch_audio[], uint16_t num_samples, int16_t pwm_audio[])
 {
   //capture usb volume and mute settings
   critical_section_enter_blocking(&usb_volumute);
@@ -426,47 +779,136 @@ uint16_t __not_in_flash_func(rx::process_block)(uint16_t adc_samples[], int16_t
   bool safe_usb_mute = usb_mute;
   critical_section_exit(&usb_volumute);
 
-  //process adc IQ samples to produce raw audio
-  int16_t usb_audio[adc_block_size/decimation_rate];
-  uint16_t num_samples = rx_dsp_inst.process_block(adc_samples, usb_audio);
-  
+  //USB audio is stereo, the main channel is on the left and the dual watch
+  //channel (or the main channel again) on the right. In iq mode, I is on the
+  //left and Q on the right. The speaker is mono and is silent in iq mode,
+  //and the host volume and mute don't apply to iq samples.
+  const bool stereo = dual_watch || usb_iq;
+  int16_t usb_right[adc_block_size/decimation_rate];
+
   //post process audio for USB and PWM
   uint16_t odx = 0;
   for(uint16_t idx=0; idx<num_samples; ++idx)
   {
-    int16_t audio = usb_audio[idx];
+    const int16_t left = usb_audio[idx];
+    const int16_t right = stereo ? dual_watch_audio[idx] : left;
+    int16_t audio = usb_iq ? 0 : ((int32_t)left + right) >> 1;
 
     //digital volume control
     audio = ((int32_t)audio * gain_numerator) >> 8;
 
-    //convert to unsigned value in range 0 to 500 to output to PWM
-    audio += INT16_MAX;
-    audio = (uint16_t)audio/pwm_scale;
-
-    //interpolate to PWM rate
-    static int16_t last_audio = 0;
-    int32_t comb = audio - last_audio;
-    last_audio = audio;
-    for(uint8_t subsample = 0; subsample < interpolation_rate; ++subsample)
-    {
-      static int32_t integrator = 0;
-      integrator += comb;
-      pwm_audio[odx++] = integrator >> 4;
-    }
+    //convert to PWM levels (0 to pwm_max) at the PWM rate
+    odx += pwm_output_inst.process_sample(audio, &pwm_audio[odx]);
 
-    //usb audio volume is controlled from usb
-    if (safe_usb_mute) {
+    //usb audio volume is controlled from usb, iq samples are passed unscaled
+    if (usb_iq) {
+      usb_right[idx] = right;
+    } else if (safe_usb_mute) {
       usb_audio[idx] = 0;
+      usb_right[idx] = 0;
     } else {
-      usb_audio[idx] = (usb_audio[idx] * safe_usb_volume)/180;
+      usb_audio[idx] = (left * safe_usb_volume)/180;
+      usb_right[idx] = (right * safe_usb_volume)/180;
     }
   }
 
-  //add usb audio to ring buffer
-  ring_buffer_push_ovr(&usb_ring_buffer, (uint8_t *)usb_audio, sizeof(int16_t) * num_samples); 
-  return num_samples * interpolation_rate;
+  //the usb callback has dropped stale audio, start again from the target level
+  if(usb_flush_done)
+  {
+    usb_flush_done = false;
+    usb_rate_matcher_inst.reset();
+  }
+
+  //follow the host clock, keeps the usb buffer level at the target latency,
+  //held while a flush is pending so that the integrator doesn't wind up
+  const uint16_t level = usb_ring.get_num_samples()/usb_channels;
+  if(!usb_flush_requested) usb_rate_matcher_inst.update(level);
+  int16_t usb_resampled[usb_channels * (adc_block_size/decimation_rate + 2)];
+  const uint16_t num_usb_samples = usb_rate_matcher_inst.process_block(usb_audio, usb_right, num_samples, usb_resampled);
+
+  //add usb audio to ring buffer, an overflow means the host isn't taking samples
+  if(usb_ring.push(usb_resampled, usb_channels * num_usb_samples) < usb_channels * num_usb_samples)
+  {
+    usb_flush_requested = true;
+  }
+
+  //level range over about one second, lowest before and highest after a block
+  usb_min_level = std::min(usb_min_level, level);
+  usb_max_level = std::max(usb_max_level, (uint16_t)(usb_ring.get_num_samples()/usb_channels));
+  if(++usb_window_count >= adc_sample_rate/adc_block_size)
+  {
+    usb_reported_min_level = usb_min_level;
+    usb_reported_max_level = usb_max_level;
+    usb_min_level = UINT16_MAX;
+    usb_max_level = 0;
+    usb_window_count = 0;
+  }
+  return num_samples * pwm_interpolation_rate;
+}
+
+//The level is measured before each block is added and drains through the
+//block, so the average latency is half a block more than the target level.
+//Latency increases are filled with silence straight away, decreases are
+//slewed by the rate matcher.
+void rx::set_usb_latency(uint8_t latency)
+{
+  usb_latency = latency < sizeof(usb_latency_ms) ? latency : 0;
+  const uint16_t block_size = adc_block_size/decimation_rate;
+  const uint16_t level = usb_latency_ms[usb_latency] * (adc_sample_rate/decimation_rate) / 1000u - block_size/2;
+  if(level == usb_target_level) return;
+
+  static const int16_t silence[64] = {0};
+  for(uint16_t fill = usb_target_level; fill < level; fill += 32)
+  {
+    usb_ring.push(silence, usb_channels * std::min(level - fill, 32));
+  }
+  usb_target_level = level;
+  usb_flush_level = usb_channels * level;
+  usb_rate_matcher_inst.set_target_level(level);
 }
 
+#ifdef DSP_PIPELINE
+//core 1, queue the decimated block for core 0, dropped if core 0 has fallen behind
+void __not_in_flash_func(rx::process_front_end)(uint16_t adc_samples[])
+{
+  s_pipeline_block *block = pipeline.get_write_block();
+  if(!block) return;
+  block->sequence = processed_sequence + 1;
+  rx_dsp_inst.process_front_end(adc_samples, block->real, block->imag);
+  pipeline.commit_write_block();
+}
+
+//Core 0, called from the SIO FIFO irq. Audio plays one block later than in
+//the single core mode, the output of block N goes to the audio buffer that
+//the dma handler starts as block N+2 completes. That buffer finished playing
+//when block N completed, so the back end has until block N+2 completes.
+void __not_in_flash_func(rx::service_pipeline)()
+{
+  //static, the irq stacks on top of whichever task it interrupted
+  static int16_t usb_audio[adc_block_size/decimation_rate];
+  static int16_t dual_watch_audio[adc_block_size/decimation_rate];
+
+  s_pipeline_block *block;
+  while((block = pipeline.get_read_block()))
+  {
+    const uint32_t start_time = time_us_32();
+    const uint32_t sequence = block->sequence;
+
+    const uint16_t num_samples = rx_dsp_inst.process_back_end(block->real, block->imag, usb_audio, dual_watch_audio);
+    pipeline.release_read_block();
+
+    const uint8_t buffer = sequence % pipeline_audio_buffers;
+    num_pipeline_samples[buffer] = output_audio(usb_audio, dual_watch_audio, num_samples, pipeline_audio[buffer]);
+
+    back_end_time = time_us_32() - start_time;
+    if((int32_t)(adc_block_sequence - sequence) >= 2)
+    {
+      back_end_late = back_end_late + 1;
+    }
+  }
+}
+#endif
+
 void rx::run()
 {
     usb_audio_device_init();
@@ -491,11 +933,25 @@ void rx::run()
       }
 
       //read other adc channels when streaming is not running
-      uint32_t timeout = 15000;
       read_batt_temp();
+      batt_temp_count = 0;
+      batt_temp_index = -1;
+      adc_block_sequence = 0;
+      processed_sequence = 0;
 
       //supress audio output until first block has completed
       audio_running = false;
+
+      #ifdef DSP_PIPELINE
+      //the first two audio blocks play before core 0 has produced anything
+      for(uint8_t buffer=0; buffer<pipeline_audio_buffers; ++buffer)
+      {
+        for(uint16_t idx=0; idx<pwm_block_size; ++idx) pipeline_audio[buffer][idx] = pwm_max/2;
+        num_pipeline_samples[buffer] = pwm_block_size;
+      }
+      pipeline.start();
+      #endif
+
       hw_clear_bits(&adc_hw->fcs, ADC_FCS_UNDER_BITS);
       hw_clear_bits(&adc_hw->fcs, ADC_FCS_OVER_BITS);
       adc_set_clkdiv(100 - 1);
@@ -514,9 +970,13 @@ void rx::run()
           //exchange data with UI (runing in core 0)
           update_status();
 
-          //periodically (or when requested) suspend streaming
-          if(timeout-- == 0 || suspend || settings_changed)
+          //suspend streaming when requested
+          if(suspend || settings_changed)
           {
+            #ifdef DSP_PIPELINE
+            //core 0 must be idle before settings are applied
+            pipeline.stop();
+            #endif
 
             dma_channel_cleanup(adc_dma_ping);
             dma_channel_cleanup(adc_dma_pong);
@@ -540,10 +1000,35 @@ void rx::run()
           //process adc data as each block completes
           dma_channel_wait_for_finish_blocking(adc_dma_ping);
           uint32_t start_time = time_us_32();
+          adc_capture_inst.capture_block(ping_samples, processed_sequence + 1);
+          #ifdef DSP_PIPELINE
+          process_front_end(ping_samples);
+          #else
           num_ping_samples = process_block(ping_samples, ping_audio);
+          #endif
           busy_time = time_us_32()-start_time;
+          check_deadline();
+
+          //battery and temperature are sampled without stopping the stream
+          if(++batt_temp_count >= batt_temp_interval)
+          {
+            batt_temp_index = insert_batt_temp();
+            if(batt_temp_index >= 0) batt_temp_count = 0;
+          }
+
           dma_channel_wait_for_finish_blocking(adc_dma_pong);
+          if(batt_temp_index >= 0)
+          {
+            extract_batt_temp(pong_samples);
+            batt_temp_index = -1;
+          }
+          adc_capture_inst.capture_block(pong_samples, processed_sequence + 1);
+          #ifdef DSP_PIPELINE
+          process_front_end(pong_samples);
+          #else
           num_pong_samples = process_block(pong_samples, pong_audio);
+          #endif
+          check_deadline();
       }
 
       //suspended state
@@ -15,6 +15,12 @@
 
 #include "rx_definitions.h"
 #include "rx_dsp.h"
+#include "pwm_output.h"
+#include "clock_governor.h"
+#include "usb_rate_matcher.h"
+#ifdef DSP_PIPELINE
+#include "dsp_pipeline.h"
+#endif
 
 struct rx_settings
 {
@@ -26,6 +32,8 @@ struct rx_settings
   uint8_t squelch;
   uint8_t bandwidth;
   uint8_t deemphasis;
+  int8_t bass;
+  int8_t treble;
   uint16_t cw_sidetone_Hz;
   uint16_t gain_cal;
   uint8_t band_1_limit;
@@ -40,16 +48,58 @@ struct rx_settings
   bool swap_iq;
   bool iq_correction;
   bool enable_auto_notch;
+  bool dual_watch;
+  int32_t dual_watch_offset_Hz;
+  uint8_t dual_watch_mode;
+  bool wideband_spectrum;
+  bool spectrum_calibrated;
+  uint8_t spectrum_average;
+  uint8_t spectrum_zoom;
+  uint8_t usb_latency;
+  bool usb_iq;
+};
+
+//selectable usb jitter buffer latency
+static const uint8_t usb_latency_ms[] = {10u, 20u, 50u};
+
+//real-time events, kept in a short log for diagnostics
+enum e_rx_event {event_deadline_missed, event_adc_overflow, event_irq_late, event_pipeline_full, event_back_end_late};
+const uint8_t rx_event_log_size = 8u;
+
+struct s_rx_event
+{
+  uint32_t time_us;
+  uint32_t sequence; //adc block in which the event was detected
+  uint8_t type;
 };
 
 struct rx_status
 {
   int32_t signal_strength_dBm;
+  int16_t snr_dB;
+  bool squelch_open;
   uint32_t busy_time;
   uint16_t temp;
   uint16_t battery;
   s_filter_control filter_config;
   uint8_t usb_buf_level;
+  uint32_t usb_underruns;
+  uint32_t usb_overruns;
+  uint16_t usb_min_level; //samples, over the last second
+  uint16_t usb_max_level;
+  uint16_t usb_latency_ms;
+  uint16_t usb_target_latency_ms;
+  uint32_t spectrum_frames_published;
+  uint32_t spectrum_frames_dropped;
+  uint32_t adc_blocks;
+  uint32_t blocks_missed;
+  uint32_t adc_overflows;
+  uint32_t irq_late;
+  uint32_t system_clock_Hz;
+  uint8_t clock_preference;
+  uint8_t cpu_load_percent;
+  uint32_t num_events; //total, the last rx_event_log_size are kept
+  s_rx_event events[rx_event_log_size];
 };
 
 class rx
@@ -62,15 +112,24 @@ class rx
   void set_usb_callbacks();
 
   //receiver configuration
+  double requested_frequency_Hz = 0;
   double tuned_frequency_Hz;
   double nco_frequency_Hz;
   double offset_frequency_Hz;
   semaphore_t settings_semaphore;
   bool settings_changed;
   bool suspend;
+  bool dual_watch = false;
+  bool wideband_spectrum = false;
   uint16_t temp;
   uint16_t battery;
 
+  //battery and temperature are sampled within the adc stream
+  uint16_t batt_temp_count = 0;
+  int16_t batt_temp_index = -1;
+  int16_t insert_batt_temp();
+  void extract_batt_temp(uint16_t samples[]);
+
   // Choose which PIO instance to use (there are two instances)
   PIO pio;
   uint offset;
@@ -96,17 +155,72 @@ class rx
   static int pwm_dma_pong;
   static dma_channel_config audio_ping_cfg;
   static dma_channel_config audio_pong_cfg;
-  static int16_t ping_audio[adc_block_size];
-  static int16_t pong_audio[adc_block_size];
+  static int16_t ping_audio[pwm_block_size];
+  static int16_t pong_audio[pwm_block_size];
   static bool audio_running;
+#ifdef DSP_PIPELINE
+  //block N is played as block N+2 completes, the back end has two blocks
+  static const uint8_t pipeline_audio_buffers = 3u;
+  static int16_t third_audio[pwm_block_size];
+  static int16_t * const pipeline_audio[pipeline_audio_buffers];
+  static uint16_t num_pipeline_samples[pipeline_audio_buffers];
+#endif
   static void dma_handler();
+#ifdef PWM_HARDWARE_PACED
+  int pwm_dma_timer;
+  void set_pwm_dma_timer(uint32_t system_clock_rate);
+#endif
+
+  //deadline and overrun telemetry, the dma handler counts completed blocks
+  static volatile uint32_t adc_block_sequence;
+  static volatile uint32_t irq_late;
+  uint32_t processed_sequence;
+  uint32_t blocks_missed = 0;
+  uint32_t adc_overflows = 0;
+  uint32_t reported_irq_late = 0;
+  uint32_t num_events = 0;
+  s_rx_event events[rx_event_log_size];
+  void log_event(uint8_t type);
+  void check_deadline();
   uint32_t pwm_max;
-  uint32_t pwm_scale;
+  pwm_output pwm_output_inst;
   uint16_t process_block(uint16_t adc_samples[], int16_t pwm_audio[]);
+  uint16_t output_audio(int16_t usb_audio[], const int16_t dual_watch_audio[], uint16_t num_samples, int16_t pwm_audio[]);
+
+#ifdef DSP_PIPELINE
+  //core 1 runs the front end, core 0 the rest of the DSP and audio output
+  dsp_pipeline pipeline;
+  void process_front_end(uint16_t adc_samples[]);
+  volatile uint32_t back_end_time = 0;
+  volatile uint32_t back_end_late = 0;
+  uint32_t reported_pipeline_full = 0;
+  uint32_t reported_back_end_late = 0;
+#endif
   
   //store busy time for performance monitoring
   uint32_t busy_time;
 
+  //system clock follows the DSP load and power source
+  clock_governor governor;
+  uint32_t system_clock_Hz = 125000000u;
+
+  //averaged usb ring buffer level
+  uint16_t usb_buf_avg_level = 0;
+  usb_rate_matcher usb_rate_matcher_inst;
+
+  //usb jitter buffer statistics, the level range is measured over a window
+  uint16_t usb_target_level = 0;
+  uint16_t usb_window_count = 0;
+  uint16_t usb_min_level = UINT16_MAX;
+  uint16_t usb_max_level = 0;
+  uint16_t usb_reported_min_level = 0;
+  uint16_t usb_reported_max_level = 0;
+  uint8_t usb_latency = 0;
+  void set_usb_latency(uint8_t latency);
+
+  //usb carries the filtered IQ instead of audio
+  bool usb_iq = false;
+
   alarm_pool_t *pool = NULL;
 
   //volume control
@@ -118,6 +232,9 @@ class rx
   void run();
   void get_spectrum(uint8_t spectrum[], uint8_t &dB10);
   void set_alarm_pool(alarm_pool_t *p);
+#ifdef DSP_PIPELINE
+  void service_pipeline();
+#endif
   rx_settings &settings_to_apply;
   rx_status &status;
   rx_dsp rx_dsp_inst;
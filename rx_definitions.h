@@ -6,7 +6,12 @@ const uint32_t adc_sample_rate = 480e3;
 const uint32_t audio_sample_rate = adc_sample_rate/2;
 const uint8_t  adc_bits = 12u;
 const uint16_t adc_max=1<<(adc_bits-1);
-const uint16_t adc_block_size = 2048u;
+//set at build time, smaller blocks give lower latency at the cost of more overhead
+#ifndef ADC_BLOCK_SIZE
+#define ADC_BLOCK_SIZE 2048
+#endif
+const uint16_t adc_block_size = ADC_BLOCK_SIZE;
+static_assert(adc_block_size == 512u || adc_block_size == 1024u || adc_block_size == 2048u, "unsupported ADC_BLOCK_SIZE");
 const uint8_t  AM = 0u;
 const uint8_t  AMSYNC = 1u;
 const uint8_t  LSB = 2u;
@@ -17,6 +22,13 @@ const uint8_t  CW = 5u;
 const uint16_t decimation_rate = 32u; //cic decimation
 const uint16_t cic_decimation_rate = decimation_rate/2u;
 const uint16_t interpolation_rate = decimation_rate/2u;
+//PWM samples per audio sample, the DMA timer paced output writes each audio sample once
+#ifdef PWM_HARDWARE_PACED
+const uint16_t pwm_interpolation_rate = 1u;
+#else
+const uint16_t pwm_interpolation_rate = interpolation_rate;
+#endif
+const uint16_t pwm_block_size = adc_block_size/decimation_rate*pwm_interpolation_rate;
 const uint16_t extra_bits = 1u;
 const uint8_t  cic_order = 4u;
 const uint8_t  cic_bit_growth = ceilf(cic_order*log2f(cic_decimation_rate));
@@ -30,4 +42,24 @@ const float S1 = -121.0f;
 const float S9 = -73.0f;
 const float S9_10 = -63.0f;
 
+//squelch settings 0-12 are S-meter levels, from here on they are SNR thresholds
+const uint8_t squelch_snr_first = 13u;
+
+//wideband spectrum is captured from one in every N adc blocks (about 15Hz)
+const uint8_t wideband_spectrum_interval = 16u*2048u/adc_block_size;
+
+//the spectrum, its averaging and the squelch measurements run once every N
+//adc blocks (about 234Hz), so their cost doesn't grow with smaller blocks
+const uint8_t spectrum_frame_interval = 2048u/adc_block_size;
+
+//battery and temperature are inserted into the adc stream once every N pong blocks (about 0.5s)
+const uint16_t batt_temp_interval = 64u*2048u/adc_block_size;
+
+//spectrum frames are calibrated in dBm with 4 fractional bits
+const uint8_t spectrum_dBm_fraction_bits = 4u;
+const int16_t spectrum_no_signal = INT16_MIN;
+//range of the calibrated (fixed scale) spectrum view
+const int16_t spectrum_min_dBm = -140;
+const int16_t spectrum_max_dBm = -20;
+
 #endif
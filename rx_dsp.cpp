@@ -9,23 +9,6 @@
 #include <cstdio>
 #include <algorithm>
 
-static const int16_t deemph_taps[2][3] = {{14430, 14430, -3909}, {10571, 10571, -11626}};
-int16_t __not_in_flash_func(rx_dsp :: apply_deemphasis)(int16_t x)
-{
-  if(deemphasis == 0)
-    return x;
-
-  static int16_t x1 = 0;
-  static int16_t y1 = 0;
-
-  size_t i = deemphasis - 1;
-
-  int16_t y = ((x * deemph_taps[i][0]) >> 15) + ((x1 * deemph_taps[i][1]) >> 15) - ((y1 * deemph_taps[0][2]) >> 15);
-  x1 = x;
-  y1 = y;
-  return y;
-}
-
 static uint32_t __not_in_flash_func(intsqrt)(const uint32_t n) {
     uint8_t shift = 32u;
     shift += shift & 1; // round up to next multiple of 2
@@ -46,22 +29,12 @@ void inline rx_dsp :: iq_imbalance_correction(int16_t &i, int16_t &q)
 {
     if (iq_correction)
     {
-      static uint16_t index = 0;
-      static int32_t theta1 = 0;
-      static int32_t theta2 = 0;
-      static int32_t theta3 = 0;
-
       theta1 += ((i < 0) ? -q : q);
       theta2 += ((i < 0) ? -i : i);
       theta3 += ((q < 0) ? -q : q);
 
-      static int32_t c1 = 0;
-      static int32_t c2 = 0;
-      if (++index == 512)
+      if (++iq_index == 512)
       {             
-        static int64_t theta1_filtered = 0;
-        static int64_t theta2_filtered = 0;
-        static int64_t theta3_filtered = 0;
         theta1_filtered = theta1_filtered - (theta1_filtered >> 5) + (-theta1 >> 5);
         theta2_filtered = theta2_filtered - (theta2_filtered >> 5) + (theta2 >> 5);
         theta3_filtered = theta3_filtered - (theta3_filtered >> 5) + (theta3 >> 5);
@@ -79,7 +52,7 @@ void inline rx_dsp :: iq_imbalance_correction(int16_t &i, int16_t &q)
         theta1 = 0;
         theta2 = 0;
         theta3 = 0;
-        index = 0;
+        iq_index = 0;
       }
 
       q += ((int32_t)i * c1) >> 15;
@@ -87,13 +60,28 @@ void inline rx_dsp :: iq_imbalance_correction(int16_t &i, int16_t &q)
     }
 }
 
-uint16_t __not_in_flash_func(rx_dsp :: process_block)(uint16_t samples[], int16_t audio_samples[])
+uint16_t __not_in_flash_func(rx_dsp :: process_block)(uint16_t samples[], int16_t audio_samples[], int16_t dual_watch_samples[])
 {
-
-  uint16_t decimated_index = 0;
-  int32_t magnitude_sum = 0;
   int16_t real[adc_block_size/cic_decimation_rate];
   int16_t imag[adc_block_size/cic_decimation_rate];
+  process_front_end(samples, real, imag);
+  return process_back_end(real, imag, audio_samples, dual_watch_samples);
+}
+
+//Runs at the adc rate: CIC decimation, DC removal, IQ correction and
+//frequency shift. Produces adc_block_size/cic_decimation_rate IQ samples.
+uint16_t __not_in_flash_func(rx_dsp :: process_front_end)(uint16_t samples[], int16_t real[], int16_t imag[])
+{
+  uint16_t decimated_index = 0;
+
+  //wideband spectrum, rate limited to keep within the processing budget
+  if(wideband_spectrum && ++wideband_count >= wideband_spectrum_interval)
+  {
+    wideband_count = 0;
+    capture_wideband(samples);
+    calibrate_spectrum(wideband_capture, capture_dBm, 0, 0, false, spectrum_offset_dB);
+    wideband_frames.publish(capture_dBm, filter_control);
+  }
 
   for(uint16_t idx=0; idx<adc_block_size; idx++)
   {
@@ -108,20 +96,16 @@ uint16_t __not_in_flash_func(rx_dsp :: process_block)(uint16_t samples[], int16_
       if(decimate(i, q))
       {
 
-        static uint32_t iq_count = 0;
-        static int32_t i_accumulator = 0;
-        static int32_t q_accumulator = 0;
-        static int16_t i_avg = 0;
-        static int16_t q_avg = 0;
+        //remove DC
         i_accumulator += i;
         q_accumulator += q;
-        if (++iq_count == 2048) //power of 2 avoids division
+        if (++dc_count == 2048) //power of 2 avoids division
         {
           i_avg = i_accumulator / 2048;
           q_avg = q_accumulator / 2048;
           i_accumulator = 0;
           q_accumulator = 0;
-          iq_count = 0;
+          dc_count = 0;
         }
         i -= i_avg;
         q -= q_avg;
@@ -151,12 +135,77 @@ uint16_t __not_in_flash_func(rx_dsp :: process_block)(uint16_t samples[], int16_
       }
   }
 
+  return decimated_index;
+}
+
+//Runs at the decimated rate: zoom spectrum, FFT filter, demodulation, audio
+//filters, AGC and squelch. The real and imag samples are modified.
+uint16_t __not_in_flash_func(rx_dsp :: process_back_end)(int16_t real[], int16_t imag[], int16_t audio_samples[], int16_t dual_watch_samples[])
+{
+  int32_t magnitude_sum = 0;
+  int16_t dual_watch_real[adc_block_size/decimation_rate];
+  int16_t dual_watch_imag[adc_block_size/decimation_rate];
+
+  //zoomed spectrum, taken before the fft filter modifies the samples
+  const bool zoom = zoom_fft_inst.get_stages() > 0;
+  bool zoom_frame = false;
+  if(zoom)
+  {
+    zoom_frame = zoom_fft_inst.process_block(real, imag, adc_block_size/cic_decimation_rate, zoom_capture);
+  }
+
+  //spectrum and squelch measurements at a fixed frame rate
+  const bool spectrum_frame = ++spectrum_count >= spectrum_frame_interval;
+  if(spectrum_frame) spectrum_count = 0;
+
   //fft filter decimates a further 2x
-  //if the capture buffer isn't in use, fill it
-  filter_control.capture = sem_try_acquire(&spectrum_semaphore);
+  filter_control.capture = spectrum_frame;
   capture_filter_control = filter_control;
-  fft_filter_inst.process_sample(real, imag, filter_control, capture);
-  if(filter_control.capture) sem_release(&spectrum_semaphore);
+  if(dual_watch && !iq_output)
+  {
+    dual_watch_filter_control.fft_bin = filter_control.fft_bin + dual_watch_bin_shift;
+    fft_filter_inst.process_sample(real, imag, filter_control, capture, dual_watch_real, dual_watch_imag, &dual_watch_filter_control);
+  }
+  else
+  {
+    fft_filter_inst.process_sample(real, imag, filter_control, capture);
+  }
+  if(zoom ? zoom_frame : spectrum_frame)
+  {
+    capture_averager.add_frame(zoom ? zoom_capture : capture);
+    capture_averager.get_frame(spectrum_average, capture_averaged);
+    calibrate_spectrum(capture_averaged, capture_dBm, capture_filter_control.fft_bin, zoom_fft_inst.get_stages(), true, spectrum_offset_dB);
+    spectrum_frames.publish(capture_dBm, capture_filter_control);
+  }
+
+  //smooth in-band and out-of-band levels measured in the fft filter
+  if(spectrum_frame)
+  {
+    main_snr.update(filter_control.signal_level, filter_control.noise_level);
+  }
+
+  //squelch
+  if(snr_enabled)
+  {
+    squelch_open = main_snr.is_open();
+  }
+  else
+  {
+    squelch_open = signal_amplitude >= squelch_threshold;
+  }
+
+  //iq output, I in the audio samples and Q in the dual watch samples
+  if(iq_output)
+  {
+    for(uint16_t idx=0; idx<adc_block_size/decimation_rate; idx++)
+    {
+      magnitude_sum += rectangular_2_magnitude(real[idx], imag[idx]);
+      audio_samples[idx] = real[idx];
+      dual_watch_samples[idx] = imag[idx];
+    }
+    signal_amplitude = (magnitude_sum * decimation_rate)/adc_block_size;
+    return adc_block_size/decimation_rate;
+  }
 
   for(uint16_t idx=0; idx<adc_block_size/decimation_rate; idx++)
   {
@@ -168,17 +217,20 @@ uint16_t __not_in_flash_func(rx_dsp :: process_block)(uint16_t samples[], int16_
     magnitude_sum += amplitude;
 
     //Demodulate to give audio sample
-    int32_t audio = demodulate(i, q);
+    audio_samples[idx] = demodulate(i, q, main_channel);
+  }
 
-    //De-emphasis
-    audio = apply_deemphasis(audio);
+  //De-emphasis, speech/CW filters and tone controls
+  audio_filter.process_block(audio_samples, adc_block_size/decimation_rate);
 
+  for(uint16_t idx=0; idx<adc_block_size/decimation_rate; idx++)
+  {
     //Automatic gain control scales signal to use full 16 bit range
     //e.g. -32767 to 32767
-    audio = automatic_gain_control(audio);
+    int16_t audio = automatic_gain_control(audio_samples[idx], main_channel);
 
     //squelch
-    if(signal_amplitude < squelch_threshold) {
+    if(!squelch_open) {
       audio = 0;
     }
 
@@ -189,9 +241,114 @@ uint16_t __not_in_flash_func(rx_dsp :: process_block)(uint16_t samples[], int16_
   //average over the number of samples
   signal_amplitude = (magnitude_sum * decimation_rate)/adc_block_size;
 
+  if(dual_watch)
+  {
+    //dual watch channel has its own demodulator, AGC and squelch but no audio shaping
+    if(spectrum_frame)
+    {
+      dual_watch_snr.update(dual_watch_filter_control.signal_level, dual_watch_filter_control.noise_level);
+    }
+    if(snr_enabled)
+    {
+      dual_watch_squelch_open = dual_watch_snr.is_open();
+    }
+    else
+    {
+      dual_watch_squelch_open = dual_watch_amplitude >= squelch_threshold;
+    }
+
+    magnitude_sum = 0;
+    for(uint16_t idx=0; idx<adc_block_size/decimation_rate; idx++)
+    {
+      //the FFT filter shifts by whole bins, remove the remaining offset
+      const uint16_t scaled_phase = (dual_watch_phase >> 21);
+      const int16_t rotation_i =  sin_table[(scaled_phase+512u) & 0x7ff];
+      const int16_t rotation_q = -sin_table[scaled_phase];
+      dual_watch_phase += dual_watch_frequency;
+      const int16_t i = (((int32_t)dual_watch_real[idx] * rotation_i) - ((int32_t)dual_watch_imag[idx] * rotation_q)) >> 15;
+      const int16_t q = (((int32_t)dual_watch_imag[idx] * rotation_i) + ((int32_t)dual_watch_real[idx] * rotation_q)) >> 15;
+
+      magnitude_sum += rectangular_2_magnitude(i, q);
+      const int16_t audio = automatic_gain_control(demodulate(i, q, dual_watch_channel), dual_watch_channel);
+      dual_watch_samples[idx] = dual_watch_squelch_open ? audio : 0;
+    }
+    dual_watch_amplitude = (magnitude_sum * decimation_rate)/adc_block_size;
+  }
+
   return adc_block_size/decimation_rate;
 }
 
+//FFT of the raw (undecimated) adc samples covering the whole 240kHz
+//I and Q are sampled alternately, so the odd stream lags by half a complex
+//sample. The even and odd streams are separated from a single complex FFT,
+//the timing skew of the odd stream is removed in the frequency domain, and
+//the two are recombined.
+void __not_in_flash_func(rx_dsp :: capture_wideband)(uint16_t samples[])
+{
+  const uint16_t n = 256u;
+  int16_t real[n];
+  int16_t imag[n];
+
+  //remove adc bias
+  int32_t even_sum = 0;
+  int32_t odd_sum = 0;
+  for(uint16_t idx=0; idx<n; idx++)
+  {
+    even_sum += samples[2*idx];
+    odd_sum += samples[2*idx+1];
+  }
+  const int16_t even_avg = even_sum/n;
+  const int16_t odd_avg = odd_sum/n;
+
+  //hann window, even samples in real and odd samples in imag
+  for(uint16_t idx=0; idx<n; idx++)
+  {
+    const int32_t window = (32767 - sin_table[(8u*idx + 512u) & 0x7ffu]) >> 1;
+    real[idx] = (((int16_t)samples[2*idx] - even_avg) * window) >> 15;
+    imag[idx] = (((int16_t)samples[2*idx+1] - odd_avg) * window) >> 15;
+  }
+
+  fixed_fft(real, imag, 8);
+
+  for(uint16_t idx=0; idx<n; idx++)
+  {
+    //Z(k) = E(k) + jO(k) where E and O are the spectra of the real even and odd streams
+    //E(k) = (Z(k) + Z*(-k))/2, O(k) = (Z(k) - Z*(-k))/2j
+    const uint16_t neg = (n - idx) & (n - 1u);
+    const int32_t zr = real[idx], zi = imag[idx];
+    const int32_t wr = real[neg], wi = imag[neg];
+    const int32_t er = (zr + wr) >> 1;
+    const int32_t ei = (zi - wi) >> 1;
+    const int32_t or_ = (zi + wi) >> 1;
+    const int32_t oi = (wr - zr) >> 1;
+
+    //the odd stream is sampled half a sample late, its spectrum is rotated by
+    //exp(j*pi*k/n) for signed bin k, so rotate it back
+    const int16_t k = idx < n/2 ? idx : idx - n;
+    const int16_t rotation_i =  sin_table[(4*k + 512) & 0x7ff];
+    const int16_t rotation_q = -sin_table[(4*k) & 0x7ff];
+    const int32_t ar = (or_ * rotation_i - oi * rotation_q) >> 15;
+    const int32_t ai = (or_ * rotation_q + oi * rotation_i) >> 15;
+
+    //X(k) = I(k) + jQ(k)
+    int32_t xr, xi;
+    if(swap_iq)
+    {
+      xr = ar - ei;
+      xi = ai + er;
+    }
+    else
+    {
+      xr = er - ai;
+      xi = ei + ar;
+    }
+    xr = std::max(std::min(xr, (int32_t)INT16_MAX), (int32_t)INT16_MIN);
+    xi = std::max(std::min(xi, (int32_t)INT16_MAX), (int32_t)INT16_MIN);
+    const uint16_t magnitude = rectangular_2_magnitude(xr, xi);
+    wideband_capture[idx] = (((int32_t)wideband_capture[idx]<<3) - wideband_capture[idx] + magnitude) >> 3;
+  }
+}
+
 void __not_in_flash_func(rx_dsp :: frequency_shift)(int16_t &i, int16_t &q)
 {
     //Apply frequency shift (move tuned frequency to DC)         
@@ -262,30 +419,27 @@ bool __not_in_flash_func(rx_dsp :: decimate)(int16_t &i, int16_t &q)
 #define AMSYNC_F_MAX (218)
 #define AMSYNC_FIX_MAX (32767)
 
-int16_t __not_in_flash_func(rx_dsp :: demodulate)(int16_t i, int16_t q)
+int16_t __not_in_flash_func(rx_dsp :: demodulate)(int16_t i, int16_t q, s_channel_state &channel)
 {
-   static int32_t phi_locked = 0;
-   static int32_t freq_locked = 0;
-
-    if(mode == AM)
+    if(channel.mode == AM)
     {
         int16_t amplitude = rectangular_2_magnitude(i, q);
         //measure DC using first order IIR low-pass filter
-        audio_dc = amplitude+(audio_dc - (audio_dc >> 5));
+        channel.audio_dc = amplitude+(channel.audio_dc - (channel.audio_dc >> 5));
         //subtract DC component
-        return amplitude - (audio_dc >> 5);
+        return amplitude - (channel.audio_dc >> 5);
     }
-    else if(mode == AMSYNC)
+    else if(channel.mode == AMSYNC)
     {
       size_t idx;
 
-      if (phi_locked < 0)
+      if (channel.phi_locked < 0)
       {
-        idx = AMSYNC_FIX_MAX + 1 + phi_locked;
+        idx = AMSYNC_FIX_MAX + 1 + channel.phi_locked;
       }
       else
       {
-        idx = phi_locked;
+        idx = channel.phi_locked;
       }
 
       // VCO
@@ -298,58 +452,58 @@ int16_t __not_in_flash_func(rx_dsp :: demodulate)(int16_t i, int16_t q)
       int16_t err = -rectangular_2_phase(synced_i, synced_q);
 
       // Loop filter
-      freq_locked += (((int32_t)AMSYNC_BETA * err) >> 15);
-      phi_locked += freq_locked + (((int32_t)AMSYNC_ALPHA * err) >> 15);
+      channel.freq_locked += (((int32_t)AMSYNC_BETA * err) >> 15);
+      channel.phi_locked += channel.freq_locked + (((int32_t)AMSYNC_ALPHA * err) >> 15);
 
       // Clamp frequency
-      if (freq_locked > AMSYNC_F_MAX)
+      if (channel.freq_locked > AMSYNC_F_MAX)
       {
-        freq_locked = AMSYNC_F_MAX;
+        channel.freq_locked = AMSYNC_F_MAX;
       }
 
-      if (freq_locked < AMSYNC_F_MIN)
+      if (channel.freq_locked < AMSYNC_F_MIN)
       {
-        freq_locked = AMSYNC_F_MIN;
+        channel.freq_locked = AMSYNC_F_MIN;
       }
 
       // Wrap phi
-      if (phi_locked > AMSYNC_FIX_MAX)
+      if (channel.phi_locked > AMSYNC_FIX_MAX)
       {
-        phi_locked -= AMSYNC_FIX_MAX + 1;
+        channel.phi_locked -= AMSYNC_FIX_MAX + 1;
       }
 
-      if (phi_locked < -AMSYNC_FIX_MAX)
+      if (channel.phi_locked < -AMSYNC_FIX_MAX)
       {
-        phi_locked += AMSYNC_FIX_MAX + 1;
+        channel.phi_locked += AMSYNC_FIX_MAX + 1;
       }
 
       // measure DC using first order IIR low-pass filter
-      audio_dc = synced_q + (audio_dc - (audio_dc >> 5));
+      channel.audio_dc = synced_q + (channel.audio_dc - (channel.audio_dc >> 5));
       // subtract DC component
-      return synced_q - (audio_dc >> 5);
+      return synced_q - (channel.audio_dc >> 5);
     }
-    else if(mode == FM)
+    else if(channel.mode == FM)
     {
         int16_t phase = rectangular_2_phase(i, q);
-        int16_t frequency = phase - last_phase;
-        last_phase = phase;
+        int16_t frequency = phase - channel.last_phase;
+        channel.last_phase = phase;
 
         return frequency;
     }
-    else if(mode == LSB || mode == USB)
+    else if(channel.mode == LSB || channel.mode == USB)
     {
         return i;
     }
     else //if(mode==cw)
     {
-      cw_sidetone_phase += cw_sidetone_frequency_Hz * 2048 * decimation_rate / adc_sample_rate;
-      const int16_t rotation_i =  sin_table[(cw_sidetone_phase + 512u) & 0x7ffu];
-      const int16_t rotation_q = -sin_table[cw_sidetone_phase & 0x7ffu];
+      channel.cw_sidetone_phase += cw_sidetone_frequency_Hz * 2048 * decimation_rate / adc_sample_rate;
+      const int16_t rotation_i =  sin_table[(channel.cw_sidetone_phase + 512u) & 0x7ffu];
+      const int16_t rotation_q = -sin_table[channel.cw_sidetone_phase & 0x7ffu];
       return ((i * rotation_i) - (q * rotation_q)) >> 15;
     }
 }
 
-int16_t __not_in_flash_func(rx_dsp::automatic_gain_control)(int16_t audio_in)
+int16_t __not_in_flash_func(rx_dsp::automatic_gain_control)(int16_t audio_in, s_channel_state &channel)
 {
     //Use a leaky max hold to estimate audio power
     //             _
@@ -374,25 +528,25 @@ int16_t __not_in_flash_func(rx_dsp::automatic_gain_control)(int16_t audio_in)
     static const uint8_t extra_bits = 16;
     int32_t audio = audio_in;
     const int32_t audio_scaled = audio << extra_bits;
-    if(audio_scaled > max_hold)
+    if(audio_scaled > channel.max_hold)
     {
       //attack
-      max_hold += (audio_scaled - max_hold) >> attack_factor;
-      hang_timer = hang_time;
+      channel.max_hold += (audio_scaled - channel.max_hold) >> attack_factor;
+      channel.hang_timer = hang_time;
     }
-    else if(hang_timer)
+    else if(channel.hang_timer)
     {
       //hang
-      hang_timer--;
+      channel.hang_timer--;
     }
-    else if(max_hold > 0)
+    else if(channel.max_hold > 0)
     {
       //decay
-      max_hold -= max_hold>>decay_factor; 
+      channel.max_hold -= channel.max_hold>>decay_factor; 
     }
 
     //calculate gain needed to amplify to full scale
-    const int16_t magnitude = max_hold >> extra_bits;
+    const int16_t magnitude = channel.max_hold >> extra_bits;
     const int16_t limit = INT16_MAX; //hard limit
     const int16_t setpoint = limit/2; //about half full scale
 
@@ -401,14 +555,14 @@ int16_t __not_in_flash_func(rx_dsp::automatic_gain_control)(int16_t audio_in)
     {
       if(manual_gain_control)
       {
-        gain = manual_gain;
+        channel.gain = manual_gain;
       }
       else
       {
-        gain = setpoint/magnitude;
+        channel.gain = setpoint/magnitude;
       }
-      if(gain < 1) gain = 1;
-      audio *= gain;
+      if(channel.gain < 1) channel.gain = 1;
+      audio *= channel.gain;
     }
 
     //soft clip (compress)
@@ -422,6 +576,14 @@ int16_t __not_in_flash_func(rx_dsp::automatic_gain_control)(int16_t audio_in)
     return audio;
 }
 
+//Spectrum frames relative to 234Hz. Unzoomed frames are taken every 2048
+//adc samples. Zoomed frames take 256 samples from the half-band cascade,
+//which gets 128 samples per 2048 adc samples.
+static int8_t spectrum_frame_rate_shift(uint8_t zoom_stages)
+{
+  return zoom_stages ? -1 - (int8_t)zoom_stages : 0;
+}
+
 rx_dsp :: rx_dsp()
 {
   //initialise state
@@ -431,12 +593,25 @@ rx_dsp :: rx_dsp()
   swap_iq = 0;
   iq_correction = 0;
 
-  //initialise semaphore for spectrum
+  //CIC droop correction in dB, applied to the calibrated spectrum
+  for(uint16_t i=0; i<129; i++)
+  {
+    cic_correction_dB[i] = magnitude_2_dB(cic_correction[i]) - magnitude_2_dB(256u);
+  }
+  set_gain_cal_dB(amplifier_gain_dB);
+
   set_mode(AM, 2);
-  sem_init(&spectrum_semaphore, 1, 1);
+  set_dual_watch(false, 0, AM, 2);
   set_agc_speed(3);
+  capture_averager.set_frame_rate_shift(spectrum_frame_rate_shift(0));
   filter_control.enable_auto_notch = false;
 
+  reset();
+}
+
+//clear all signal processing state, settings are left unchanged
+void rx_dsp :: reset()
+{
   //clear cic filter
   decimate_count=0;
   integratori1=0; integratorq1=0;
@@ -447,6 +622,73 @@ rx_dsp :: rx_dsp()
   delayi1=0; delayq1=0;
   delayi2=0; delayq2=0;
   delayi3=0; delayq3=0;
+
+  //clear dc removal
+  dc_count = 0;
+  i_accumulator = 0; q_accumulator = 0;
+  i_avg = 0; q_avg = 0;
+
+  //clear iq imbalance correction
+  iq_index = 0;
+  theta1 = 0; theta2 = 0; theta3 = 0;
+  theta1_filtered = 0; theta2_filtered = 0; theta3_filtered = 0;
+  c1 = 0; c2 = 0;
+
+  //clear frequency shifter and filters
+  phase = 0;
+  fft_filter_inst.reset();
+  audio_filter.reset();
+
+  //clear demodulators and agc
+  clear_channel(main_channel);
+  clear_channel(dual_watch_channel);
+  dual_watch_phase = 0;
+
+  //clear signal measurements
+  signal_amplitude = 0;
+  main_snr.reset();
+  squelch_open = !snr_enabled;
+  dual_watch_amplitude = 0;
+  dual_watch_snr.reset();
+  dual_watch_squelch_open = !snr_enabled;
+  spectrum_max = magnitude_2_dB(65523u) + spectrum_offset_dB;
+  spectrum_min = spectrum_offset_dB;
+  wideband_max = magnitude_2_dB(65523u) + spectrum_offset_dB;
+  wideband_min = spectrum_offset_dB;
+  wideband_count = 0;
+  spectrum_count = 0;
+  for(uint16_t i=0; i<256; i++) wideband_capture[i] = 0;
+  capture_averager.reset();
+  zoom_fft_inst.reset();
+}
+
+//after a retune only the filter and demodulator history is stale, keep the
+//iq/dc calibration, agc and display scaling (owned by core 0)
+void rx_dsp :: retune()
+{
+  phase = 0;
+  fft_filter_inst.reset();
+  audio_filter.reset();
+  clear_demodulator(main_channel);
+  clear_demodulator(dual_watch_channel);
+  dual_watch_phase = 0;
+}
+
+void rx_dsp :: clear_demodulator(s_channel_state &channel)
+{
+  channel.audio_dc = 0;
+  channel.last_phase = 0;
+  channel.phi_locked = 0;
+  channel.freq_locked = 0;
+  channel.cw_sidetone_phase = 0;
+}
+
+void rx_dsp :: clear_channel(s_channel_state &channel)
+{
+  clear_demodulator(channel);
+  channel.max_hold = 0;
+  channel.hang_timer = 0;
+  channel.gain = 1;
 }
 
 void rx_dsp :: set_auto_notch(bool enable_auto_notch)
@@ -457,6 +699,38 @@ void rx_dsp :: set_auto_notch(bool enable_auto_notch)
 void rx_dsp :: set_deemphasis(uint8_t deemph)
 {
   deemphasis = deemph;
+  update_audio_filters();
+}
+
+void rx_dsp :: set_tone(int8_t bass_setting, int8_t treble_setting)
+{
+  bass = bass_setting;
+  treble = treble_setting;
+  update_audio_filters();
+}
+
+//Design the audio biquad cascade, called whenever a setting that affects it
+//changes. Only sections whose coefficients change are replaced.
+void rx_dsp :: update_audio_filters()
+{
+  const float audio_fs = (float)adc_sample_rate/decimation_rate;
+  biquad_filter design;
+
+  //FM de-emphasis 50us/75us
+  if(deemphasis == 1) design.add_first_order_lowpass(50e-6f, audio_fs);
+  if(deemphasis == 2) design.add_first_order_lowpass(75e-6f, audio_fs);
+
+  //remove low frequency rumble from SSB speech
+  if(main_channel.mode == LSB || main_channel.mode == USB) design.add_highpass(250.0f, 0.707f, audio_fs);
+
+  //audio peak filter centred on the CW tone
+  if(main_channel.mode == CW) design.add_bandpass(cw_sidetone_frequency_Hz, 4.0f, audio_fs);
+
+  //user tone controls in 2dB steps
+  if(bass) design.add_low_shelf(300.0f, 2.0f*bass, audio_fs);
+  if(treble) design.add_high_shelf(2500.0f, 2.0f*treble, audio_fs);
+
+  audio_filter.update(design);
 }
 
 void rx_dsp :: set_agc_speed(uint8_t agc_setting)
@@ -519,7 +793,53 @@ void rx_dsp :: set_frequency_offset_Hz(double offset_frequency)
 
 void rx_dsp :: set_mode(uint8_t val, uint8_t bw)
 {
-  mode = val;
+  main_channel.mode = val;
+  set_passband(filter_control, val, bw);
+
+  //iq output passes both sidebands up to just below the 7.5kHz nyquist limit
+  if(iq_output)
+  {
+    filter_control.lower_sideband = true;
+    filter_control.upper_sideband = true;
+    filter_control.start_bin = 0;
+    filter_control.stop_bin = 60;
+  }
+  update_audio_filters();
+}
+
+//takes effect at the next set_mode
+void rx_dsp :: set_iq_output(bool enable)
+{
+  iq_output = enable;
+}
+
+//offset_Hz is relative to the main channel, it must lie within the captured bandwidth
+void rx_dsp :: set_dual_watch(bool enable, int32_t offset_Hz, uint8_t mode, uint8_t bw)
+{
+  //the mode indexes the pass band tables, fall back to AM if out of range
+  if(mode > CW) mode = AM;
+
+  const float bin_width = (float)adc_sample_rate/(cic_decimation_rate*256);
+  const float audio_fs = (float)adc_sample_rate/decimation_rate;
+
+  //coarse shift in whole FFT bins and fine shift of the residual
+  dual_watch_bin_shift = roundf(offset_Hz/bin_width);
+  const float residual_Hz = offset_Hz - dual_watch_bin_shift*bin_width;
+  dual_watch_frequency = (int32_t)((double)(1ull<<32)*residual_Hz/audio_fs);
+
+  if(dual_watch_channel.mode != mode || dual_watch != enable)
+  {
+    clear_channel(dual_watch_channel);
+  }
+  dual_watch_channel.mode = mode;
+  set_passband(dual_watch_filter_control, mode, bw);
+  dual_watch_filter_control.capture = false;
+  dual_watch_filter_control.enable_auto_notch = false;
+  dual_watch = enable;
+}
+
+void rx_dsp :: set_passband(s_filter_control &control, uint8_t mode, uint8_t bw)
+{
   //                           AM AMS LSB USB NFM CW
   uint8_t start_bins[6]   =  {  0,  0,  3,  3,  0, 0};
 
@@ -529,10 +849,15 @@ void rx_dsp :: set_mode(uint8_t val, uint8_t bw)
                              { 28, 28, 25, 25, 40, 3},  //wide
                              { 31, 31, 28, 28, 43, 4}}; //very wide
 
-  filter_control.lower_sideband = (mode != USB);
-  filter_control.upper_sideband = (mode != LSB);
-  filter_control.start_bin = start_bins[mode];
-  filter_control.stop_bin = stop_bins[bw][mode];
+  control.lower_sideband = (mode != USB);
+  control.upper_sideband = (mode != LSB);
+  control.start_bin = start_bins[mode];
+  control.stop_bin = stop_bins[bw][mode];
+}
+
+void rx_dsp :: set_wideband_spectrum(bool enable)
+{
+  wideband_spectrum = enable;
 }
 
 void rx_dsp :: set_swap_iq(uint8_t val)
@@ -548,18 +873,48 @@ void rx_dsp :: set_iq_correction(uint8_t val)
 void rx_dsp :: set_cw_sidetone_Hz(uint16_t val)
 {
   cw_sidetone_frequency_Hz = val;
+  update_audio_filters();
 }
 
 void rx_dsp :: set_gain_cal_dB(uint16_t val)
 {
   amplifier_gain_dB = val;
   s9_threshold = full_scale_signal_strength*powf(10.0f, (S9 - full_scale_dBm + amplifier_gain_dB)/20.0f);
+
+  //Spectrum calibration, a tone of amplitude A at the fft filter input gives
+  //a bin magnitude of 8A (hann window 0.5 x 256 point FFT scaled by 1/16) and
+  //a signal strength amplitude of 2A. A tone of adc amplitude a gives A = a
+  //(CIC gain of 2, but I and Q each only use every other sample) and a
+  //wideband bin magnitude of 8a, so both spectra use the same offset.
+  const float offset_dB = full_scale_dBm - amplifier_gain_dB - 20.0f*log10f(full_scale_signal_strength);
+  spectrum_offset_dB = 256.0f*(offset_dB - 20.0f*log10f(4.0f));
+}
+
+void rx_dsp :: set_spectrum_average(uint8_t mode)
+{
+  spectrum_average = mode;
+}
+
+void rx_dsp :: set_spectrum_zoom(uint8_t zoom)
+{
+  //zoom levels 2, 3 and 4 decimate by 2, 4 and 8 before the FFT
+  const uint8_t stages = zoom > 1 ? zoom - 1 : 0;
+  if(stages != zoom_fft_inst.get_stages())
+  {
+    zoom_fft_inst.set_stages(stages);
+    capture_averager.set_frame_rate_shift(spectrum_frame_rate_shift(stages));
+  }
+}
+
+void rx_dsp :: set_spectrum_calibrated(bool enable)
+{
+  spectrum_calibrated = enable;
 }
 
 //set_squelch
 void rx_dsp :: set_squelch(uint8_t val)
 {
-  //0-9 = s0 to s9, 10 to 12 = S9+10dB to S9+30dB
+  //0-9 = s0 to s9, 10 to 12 = S9+10dB to S9+30dB, 13 to 17 = SNR 3dB to 20dB
   const int16_t thresholds[] = {
     (int16_t)(s9_threshold>>9), //s0
     (int16_t)(s9_threshold>>8), //s1
@@ -575,7 +930,31 @@ void rx_dsp :: set_squelch(uint8_t val)
     (int16_t)(s9_threshold*10), //s9+20dB
     (int16_t)(s9_threshold*31), //s9+30dB
   };
-  squelch_threshold = thresholds[val];
+
+  if(val >= squelch_snr_first)
+  {
+    //SNR squelch opens at threshold and closes up to 3dB below
+    const float snr_thresholds_dB[] = {3.0f, 6.0f, 10.0f, 15.0f, 20.0f};
+    const float threshold_dB = snr_thresholds_dB[std::min(val - squelch_snr_first, 4)];
+    main_snr.set_threshold_dB(threshold_dB);
+    dual_watch_snr.set_threshold_dB(threshold_dB);
+    snr_enabled = true;
+  }
+  else
+  {
+    squelch_threshold = thresholds[val];
+    snr_enabled = false;
+  }
+}
+
+bool rx_dsp :: get_squelch_open()
+{
+  return squelch_open;
+}
+
+int16_t rx_dsp :: get_snr_dB()
+{
+  return main_snr.get_snr_dB();
 }
 
 int16_t rx_dsp :: get_signal_strength_dBm()
@@ -593,16 +972,6 @@ s_filter_control rx_dsp :: get_filter_config()
   return capture_filter_control;
 }
 
-static int16_t cic_correct(int16_t fft_bin, int16_t fft_offset, uint16_t magnitude)
-{
-  int16_t corrected_fft_bin = (fft_bin + fft_offset);
-  if(corrected_fft_bin > 127) corrected_fft_bin -= 256;
-  if(corrected_fft_bin < -128) corrected_fft_bin += 256;
-  uint16_t unsigned_fft_bin = abs(corrected_fft_bin); 
-  uint32_t adjusted_magnitude = ((uint32_t)magnitude * cic_correction[unsigned_fft_bin]) >> 8;
-  return std::min(adjusted_magnitude, (uint32_t)UINT16_MAX);
-}
-
 static inline int8_t freq_bin(uint8_t bin)
 {
   return bin > 127 ? bin - 256 : bin;
@@ -613,45 +982,111 @@ static inline uint8_t fft_shift(uint8_t bin)
   return bin ^ 0x80;
 }
 
+//convert captured magnitudes to calibrated dBm, called on core 1 as each frame completes
+void __not_in_flash_func(rx_dsp :: calibrate_spectrum)(const uint16_t magnitudes[], int16_t dBm[], int16_t fft_bin, uint8_t zoom_stages, bool correct_cic, int32_t offset_dB)
+{
+  for(uint16_t i=0; i<256; i++)
+  {
+    if(magnitudes[i] == 0)
+    {
+      dBm[i] = spectrum_no_signal;
+      continue;
+    }
+    int32_t dB = magnitude_2_dB(magnitudes[i]) + offset_dB;
+    if(correct_cic)
+    {
+      //zoomed bins are narrower than the fft filter bins
+      int16_t corrected_fft_bin = (freq_bin(i) >> zoom_stages) + fft_bin;
+      if(corrected_fft_bin > 127) corrected_fft_bin -= 256;
+      if(corrected_fft_bin < -128) corrected_fft_bin += 256;
+      dB += cic_correction_dB[abs(corrected_fft_bin)];
+    }
+    dBm[i] = dB >> (8 - spectrum_dBm_fraction_bits);
+  }
+}
+
 void rx_dsp :: get_spectrum(uint8_t spectrum[], uint8_t &dB10)
 {
-  //FFT and magnitude
-  sem_acquire_blocking(&spectrum_semaphore);
+  //latest frame from core 1
+  int16_t frame[256];
+  s_filter_control frame_filter_control;
+  spectrum_frames.read(frame, frame_filter_control);
+
+  scale_spectrum(frame, spectrum, magnitude_2_dB(2500u) + spectrum_offset_dB, spectrum_max, spectrum_min, dB10);
+}
+
+void rx_dsp :: get_wideband_spectrum(uint8_t spectrum[], uint8_t &dB10)
+{
+  //the capture is centred on the NCO, move the tuned frequency to the centre
+  const float bin_width = (float)adc_sample_rate/(2*256);
+  const int16_t shift = roundf(offset_frequency_Hz/bin_width);
 
-  //find minimum and maximum values
-  const uint16_t lowest_max = 2500u;
-  static uint16_t max=65523u;//long term maximum
-  uint16_t new_max=0u;
-  static uint16_t min=1u;//long term maximum
-  uint16_t new_min=65535u;
+  int16_t frame[256];
+  s_filter_control frame_filter_control;
+  wideband_frames.read(frame, frame_filter_control);
+
+  //bins beyond the edge of the capture are blank rather than wrapped around
+  int16_t shifted[256];
   for(uint16_t i=0; i<256; ++i)
   {
-    const uint16_t magnitude = cic_correct(freq_bin(i), capture_filter_control.fft_bin, capture[i]);
-    if(magnitude == 0) continue;
-    new_max = std::max(magnitude, new_max);
-    new_min = std::min(magnitude, new_min);
+    const int16_t bin = (int8_t)i + shift;
+    shifted[i] = (bin < -128 || bin > 127) ? spectrum_no_signal : frame[bin & 0xff];
   }
-  max=max - (max >> 1) + (new_max >> 1);
-  min=min - (min >> 1) + (new_min >> 1);
-  const float logmin = log10f(min);
-  const float logmax = log10f(std::max(max, lowest_max));
 
-  //clamp and convert to log scale 0 -> 255
+  scale_spectrum(shifted, spectrum, magnitude_2_dB(2500u) + spectrum_offset_dB, wideband_max, wideband_min, dB10);
+}
+
+void rx_dsp :: get_spectrum_frame_counts(uint32_t &published, uint32_t &dropped)
+{
+  published = spectrum_frames.get_published();
+  dropped = spectrum_frames.get_dropped();
+}
+
+//Convert calibrated dBm (in FFT order) to a scale 0 -> 255 centred on DC.
+//Either a fixed dBm range, or auto ranged between the (smoothed) minimum and maximum
+//All levels are dBm with 8 fractional bits
+void rx_dsp :: scale_spectrum(const int16_t dBm[], uint8_t spectrum[], int32_t lowest_max, int32_t &smoothed_max, int32_t &smoothed_min, uint8_t &dB10)
+{
+  int32_t logmin = (int32_t)spectrum_min_dBm << 8;
+  int32_t logmax = (int32_t)spectrum_max_dBm << 8;
+
+  if(!spectrum_calibrated)
+  {
+    //find minimum and maximum values
+    int32_t new_max=INT32_MIN;
+    int32_t new_min=INT32_MAX;
+    for(uint16_t i=0; i<256; ++i)
+    {
+      if(dBm[i] == spectrum_no_signal) continue;
+      const int32_t dB = (int32_t)dBm[i] << (8 - spectrum_dBm_fraction_bits);
+      new_max = std::max(dB, new_max);
+      new_min = std::min(dB, new_min);
+    }
+    if(new_min != INT32_MAX)
+    {
+      smoothed_max=smoothed_max - (smoothed_max >> 1) + (new_max >> 1);
+      smoothed_min=smoothed_min - (smoothed_min >> 1) + (new_min >> 1);
+    }
+    logmin = smoothed_min;
+    logmax = std::max(smoothed_max, lowest_max);
+  }
+
+  const int32_t range = std::max(logmax - logmin, (int32_t)256); //at least 1dB
+  const int32_t scale = (255 << 16) / range;
+
+  //clamp and convert to 0 -> 255
   for(uint16_t i=0; i<256; i++)
   {
-    const uint16_t magnitude = cic_correct(freq_bin(i), capture_filter_control.fft_bin, capture[i]);
-    if(magnitude == 0)
+    if(dBm[i] == spectrum_no_signal)
     {
       spectrum[fft_shift(i)] = 0u;
     } else {
-      const float normalised = 255.0f*(log10f(magnitude)-logmin)/(logmax-logmin);
-      const float clamped = std::max(std::min(normalised, 255.0f), 0.0f);
-      spectrum[fft_shift(i)] = clamped;
+      const int32_t dB = (int32_t)dBm[i] << (8 - spectrum_dBm_fraction_bits);
+      const int32_t clamped = std::max(std::min(dB - logmin, range), (int32_t)0);
+      spectrum[fft_shift(i)] = (clamped * scale) >> 16;
     }
   }
 
-  sem_release(&spectrum_semaphore);
-
   //number steps representing 10dB
-  dB10 = 256/(2*logf(max/min));
+  dB10 = std::min((255 * 10 * 256) / range, (int32_t)255);
 }
@@ -3,15 +3,41 @@
 
 #include <stdint.h>
 #include "rx_definitions.h"
-#include "pico/sem.h"
 #include "fft_filter.h"
+#include "biquad_filter.h"
+#include "spectrum_snapshot.h"
+#include "spectrum_averager.h"
+#include "zoom_fft.h"
+#include "snr_squelch.h"
+
+//per channel demodulator and AGC state, the main receiver and the dual
+//watch receiver each have one
+struct s_channel_state
+{
+  //used in demodulator
+  uint8_t mode;
+  int32_t audio_dc;
+  int16_t last_phase;
+  int32_t phi_locked;
+  int32_t freq_locked;
+  int16_t cw_sidetone_phase;
+
+  //used in AGC
+  uint16_t hang_timer;
+  int32_t max_hold;
+  int16_t gain;
+};
 
 class rx_dsp
 {
   public:
 
   rx_dsp();
-  uint16_t process_block(uint16_t samples[], int16_t audio_samples[]);
+  void reset();
+  void retune();
+  uint16_t process_block(uint16_t samples[], int16_t audio_samples[], int16_t dual_watch_samples[]);
+  uint16_t process_front_end(uint16_t samples[], int16_t real[], int16_t imag[]);
+  uint16_t process_back_end(int16_t real[], int16_t imag[], int16_t audio_samples[], int16_t dual_watch_samples[]);
   void set_frequency_offset_Hz(double offset_frequency);
   void set_agc_speed(uint8_t agc_setting);
   void set_mode(uint8_t mode, uint8_t bw);
@@ -21,9 +47,20 @@ class rx_dsp
   void set_swap_iq(uint8_t val);
   void set_iq_correction(uint8_t val);
   void set_deemphasis(uint8_t deemphasis);
+  void set_tone(int8_t bass, int8_t treble);
   void set_auto_notch(bool enable_auto_notch);
+  void set_dual_watch(bool enable, int32_t offset_Hz, uint8_t mode, uint8_t bw);
+  void set_iq_output(bool enable);
+  void set_wideband_spectrum(bool enable);
+  void set_spectrum_calibrated(bool enable);
+  void set_spectrum_average(uint8_t mode);
+  void set_spectrum_zoom(uint8_t zoom);
   int16_t get_signal_strength_dBm();
+  int16_t get_snr_dB();
+  bool get_squelch_open();
   void get_spectrum(uint8_t spectrum[], uint8_t &dB10);
+  void get_wideband_spectrum(uint8_t spectrum[], uint8_t &dB10);
+  void get_spectrum_frame_counts(uint32_t &published, uint32_t &dropped);
   s_filter_control get_filter_config();
   void get_spectrum(float spectrum[]);
 
@@ -31,14 +68,43 @@ class rx_dsp
   
   void frequency_shift(int16_t &i, int16_t &q);
   bool decimate(int16_t &i, int16_t &q);
-  int16_t demodulate(int16_t i, int16_t q);
-  int16_t automatic_gain_control(int16_t audio);
-  int16_t apply_deemphasis(int16_t x);
+  int16_t demodulate(int16_t i, int16_t q, s_channel_state &channel);
+  int16_t automatic_gain_control(int16_t audio, s_channel_state &channel);
+  void clear_channel(s_channel_state &channel);
+  void clear_demodulator(s_channel_state &channel);
+  static void set_passband(s_filter_control &control, uint8_t mode, uint8_t bw);
+  void update_audio_filters();
   void iq_imbalance_correction(int16_t &i, int16_t &q);
+  void capture_wideband(uint16_t samples[]);
+  void calibrate_spectrum(const uint16_t magnitudes[], int16_t dBm[], int16_t fft_bin, uint8_t zoom_stages, bool correct_cic, int32_t offset_dB);
+  void scale_spectrum(const int16_t dBm[], uint8_t spectrum[], int32_t lowest_max, int32_t &smoothed_max, int32_t &smoothed_min, uint8_t &dB10);
 
-  //capture samples for spectral analysis
+  //capture samples for spectral analysis, completed frames are calibrated
+  //in dBm and handed to core 0
   int16_t capture[256];
-  semaphore_t spectrum_semaphore;
+  spectrum_averager capture_averager;
+  uint8_t spectrum_average=average_fast;
+  uint16_t capture_averaged[256];
+  int16_t capture_dBm[256];
+  spectrum_snapshot spectrum_frames;
+  bool spectrum_calibrated=false;
+  int32_t spectrum_offset_dB=0; //magnitude to dBm, 8 fractional bits
+  int16_t cic_correction_dB[129];
+  int32_t spectrum_max; //dB, 8 fractional bits
+  int32_t spectrum_min;
+
+  //zoomed spectrum, narrower bins from a further decimated stream
+  zoom_fft zoom_fft_inst;
+  int16_t zoom_capture[256];
+
+  //wideband spectrum, taken directly from the raw adc samples
+  bool wideband_spectrum=false;
+  uint8_t wideband_count=0;
+  uint8_t spectrum_count=0;
+  uint16_t wideband_capture[256];
+  spectrum_snapshot wideband_frames;
+  int32_t wideband_max;
+  int32_t wideband_min;
 
   //used in cic decimator
   uint8_t decimate_count;
@@ -57,6 +123,17 @@ class rx_dsp
   s_filter_control filter_control;
   s_filter_control capture_filter_control;
 
+  //used in dc removal
+  uint16_t dc_count;
+  int32_t i_accumulator, q_accumulator;
+  int16_t i_avg, q_avg;
+
+  //used in iq imbalance correction
+  uint16_t iq_index;
+  int32_t theta1, theta2, theta3;
+  int64_t theta1_filtered, theta2_filtered, theta3_filtered;
+  int32_t c1, c2;
+
   //used in frequency shifter
   uint8_t swap_iq;
   uint8_t iq_correction;
@@ -67,37 +144,54 @@ class rx_dsp
 
   //used to generate cw sidetone
   int16_t cw_i, cw_q;
-  int16_t cw_sidetone_phase;
   int16_t cw_sidetone_frequency_Hz=1000;
 
   int32_t signal_amplitude;
 
   //used in demodulator
-  int32_t mode=0;
-  int32_t audio_dc=0;
+  s_channel_state main_channel;
   uint8_t ssb_phase=0;
-  int16_t last_phase=0;
 
-  // de-emphasis
+  //dual watch, a second channel within the captured bandwidth
+  //shares the forward FFT with the main channel
+  bool dual_watch=false;
+  s_channel_state dual_watch_channel;
+  s_filter_control dual_watch_filter_control;
+  int16_t dual_watch_bin_shift=0; //coarse offset in FFT bins
+  uint32_t dual_watch_phase=0; //fine offset applied after the FFT filter
+  uint32_t dual_watch_frequency=0;
+  int32_t dual_watch_amplitude=0;
+  snr_squelch dual_watch_snr;
+  bool dual_watch_squelch_open=true;
+
+  //iq output, the filtered baseband replaces the audio and the host
+  //demodulates, the demodulators are not run
+  bool iq_output=false;
+
+  //audio shaping (de-emphasis, speech/cw filters and tone controls)
+  biquad_filter audio_filter;
   uint8_t deemphasis=0;
+  int8_t bass=0;
+  int8_t treble=0;
 
   //squelch
   int16_t squelch_threshold=0;
   int16_t s9_threshold=0;
+  bool squelch_open=true;
+
+  //SNR squelch, also measures the SNR when the squelch is set by S-meter level
+  bool snr_enabled=false;
+  snr_squelch main_snr;
 
   //used in AGC
   uint8_t attack_factor;
   uint8_t decay_factor;
   uint16_t hang_time;
-  uint16_t hang_timer;
-  int32_t max_hold;
-  int16_t gain;
   int16_t manual_gain;
   bool manual_gain_control = false;
 
   // gain calibration
   float amplifier_gain_dB = 62.0f;
-  int32_t usb_buf_level_avg = 0;
 
 };
 
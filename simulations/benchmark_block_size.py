@@ -0,0 +1,11 @@
+from subprocess import run
+
+#host timings are only useful for comparing block sizes, not for absolute
+#numbers on the pico
+for block_size in [512, 1024, 2048]:
+  run(["g++", "-O2", "-DSIMULATION=true", "-DADC_BLOCK_SIZE=%u"%block_size,
+       "../utils.cpp", "../fft.cpp", "../fft_filter.cpp", "../cic_corrections.cpp",
+       "../spectrum_averager.cpp", "../zoom_fft.cpp",
+       "block_size_benchmark.cpp", "-o", "block_size_benchmark"], check=True)
+  output = run("./block_size_benchmark", capture_output=True)
+  print(output.stdout.decode("utf8").strip())
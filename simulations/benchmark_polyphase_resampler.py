@@ -0,0 +1,8 @@
+from subprocess import run
+
+#host timings are only useful for comparing against the other DSP stages,
+#not for absolute numbers on the pico
+run(["g++", "-O2", "-DSIMULATION=true", "../polyphase_resampler.cpp",
+     "polyphase_resampler_benchmark.cpp", "-o", "polyphase_resampler_benchmark"], check=True)
+output = run("./polyphase_resampler_benchmark", capture_output=True)
+print(output.stdout.decode("utf8").strip())
@@ -0,0 +1,222 @@
+#include "../biquad_filter.h"
+#include <cstdio>
+#include <cmath>
+#include <complex>
+
+//check the Q12 biquad kernel against a double precision reference design
+static const double fs = 15000.0;
+static const double amplitude = 2000.0;
+
+enum e_type {lowpass, highpass, bandpass, low_shelf, high_shelf};
+
+struct s_design
+{
+  const char *name;
+  e_type type;
+  double frequency_Hz; //time constant for the first order lowpass
+  double parameter;    //q or shelf gain in dB
+};
+
+static void reference_coefficients(const s_design &d, double b[3], double a[3])
+{
+  if(d.type == lowpass)
+  {
+    const double k = tan(1.0/(2.0 * d.frequency_Hz * fs));
+    b[0] = k; b[1] = k; b[2] = 0.0;
+    a[0] = 1.0 + k; a[1] = k - 1.0; a[2] = 0.0;
+    return;
+  }
+
+  const double w0 = 2.0 * M_PI * d.frequency_Hz / fs;
+  const double c = cos(w0);
+  if(d.type == highpass || d.type == bandpass)
+  {
+    const double alpha = sin(w0)/(2.0 * d.parameter);
+    if(d.type == highpass)
+    {
+      b[0] = (1.0 + c)/2.0; b[1] = -(1.0 + c); b[2] = (1.0 + c)/2.0;
+    }
+    else
+    {
+      b[0] = alpha; b[1] = 0.0; b[2] = -alpha;
+    }
+    a[0] = 1.0 + alpha; a[1] = -2.0 * c; a[2] = 1.0 - alpha;
+    return;
+  }
+
+  const double g = pow(10.0, d.parameter/40.0);
+  const double beta = sin(w0) * sqrt(g) * M_SQRT1_2 * 2.0;
+  const double sign = d.type == low_shelf ? 1.0 : -1.0;
+  b[0] = g * ((g + 1.0) - sign * (g - 1.0) * c + beta);
+  b[1] = sign * 2.0 * g * ((g - 1.0) - sign * (g + 1.0) * c);
+  b[2] = g * ((g + 1.0) - sign * (g - 1.0) * c - beta);
+  a[0] = (g + 1.0) + sign * (g - 1.0) * c + beta;
+  a[1] = -sign * 2.0 * ((g - 1.0) + sign * (g + 1.0) * c);
+  a[2] = (g + 1.0) + sign * (g - 1.0) * c - beta;
+}
+
+//quantized rounds the coefficients to Q12 as the filter does, so that the
+//kernel can be checked separately from the coefficient precision
+static double reference_gain(const s_design &d, double frequency_Hz, bool quantized)
+{
+  double b[3], a[3];
+  reference_coefficients(d, b, a);
+  if(quantized)
+  {
+    const double scale = (1 << biquad_fraction_bits)/a[0];
+    for(uint8_t k = 0; k < 3; ++k)
+    {
+      b[k] = round(b[k] * scale)/(1 << biquad_fraction_bits);
+      a[k] = k ? round(a[k] * scale)/(1 << biquad_fraction_bits) : 1.0;
+    }
+  }
+  const std::complex<double> z = std::polar(1.0, -2.0 * M_PI * frequency_Hz / fs);
+  return std::abs((b[0] + b[1] * z + b[2] * z * z)/(a[0] + a[1] * z + a[2] * z * z));
+}
+
+static void build(biquad_filter &filter, const s_design &d)
+{
+  filter.clear();
+  filter.reset();
+  switch(d.type)
+  {
+    case lowpass: filter.add_first_order_lowpass(d.frequency_Hz, fs); break;
+    case highpass: filter.add_highpass(d.frequency_Hz, d.parameter, fs); break;
+    case bandpass: filter.add_bandpass(d.frequency_Hz, d.parameter, fs); break;
+    case low_shelf: filter.add_low_shelf(d.frequency_Hz, d.parameter, fs); break;
+    case high_shelf: filter.add_high_shelf(d.frequency_Hz, d.parameter, fs); break;
+  }
+}
+
+//gain of a sine after the transient has died away
+static double measure_gain(const s_design &d, double frequency_Hz)
+{
+  biquad_filter filter;
+  build(filter, d);
+
+  const uint16_t block_size = 500;
+  const uint16_t settle_blocks = 30;
+  const uint16_t measure_blocks = 30;
+  double sum_i = 0.0, sum_q = 0.0;
+  uint32_t t = 0;
+  for(uint16_t block = 0; block < settle_blocks + measure_blocks; ++block)
+  {
+    int16_t samples[block_size];
+    for(uint16_t idx = 0; idx < block_size; ++idx)
+    {
+      samples[idx] = lround(amplitude * sin(2.0 * M_PI * frequency_Hz * (t + idx) / fs));
+    }
+    filter.process_block(samples, block_size);
+    for(uint16_t idx = 0; idx < block_size; ++idx, ++t)
+    {
+      if(block < settle_blocks) continue;
+      sum_i += samples[idx] * sin(2.0 * M_PI * frequency_Hz * t / fs);
+      sum_q += samples[idx] * cos(2.0 * M_PI * frequency_Hz * t / fs);
+    }
+  }
+  const double n = (double)block_size * measure_blocks;
+  return 2.0 * sqrt(sum_i * sum_i + sum_q * sum_q) / n / amplitude;
+}
+
+//after an impulse the output must decay to (at most) a +/-1 limit cycle
+static bool check_stability(const s_design &d)
+{
+  biquad_filter filter;
+  build(filter, d);
+
+  const uint16_t block_size = 500;
+  const uint16_t blocks = 60;
+  int16_t peak_tail = 0;
+  for(uint16_t block = 0; block < blocks; ++block)
+  {
+    int16_t samples[block_size] = {0};
+    if(block == 0) samples[0] = 16000;
+    filter.process_block(samples, block_size);
+    if(block < blocks - 2) continue;
+    for(uint16_t idx = 0; idx < block_size; ++idx)
+    {
+      const int16_t magnitude = abs(samples[idx]);
+      peak_tail = magnitude > peak_tail ? magnitude : peak_tail;
+    }
+  }
+  printf("%-24s impulse tail peak %i\n", d.name, peak_tail);
+  return peak_tail <= 1;
+}
+
+//re-applying identical coefficients mid-stream must not disturb the output
+static bool check_update(const s_design &d)
+{
+  biquad_filter continuous, updated, design;
+  build(continuous, d);
+  build(updated, d);
+  build(design, d);
+
+  const uint16_t block_size = 500;
+  uint32_t t = 0;
+  for(uint16_t block = 0; block < 4; ++block)
+  {
+    int16_t a[block_size], b[block_size];
+    for(uint16_t idx = 0; idx < block_size; ++idx, ++t)
+    {
+      a[idx] = b[idx] = lround(amplitude * sin(2.0 * M_PI * 440.0 * t / fs));
+    }
+    continuous.process_block(a, block_size);
+    updated.update(design);
+    updated.process_block(b, block_size);
+    for(uint16_t idx = 0; idx < block_size; ++idx)
+    {
+      if(a[idx] != b[idx]) return false;
+    }
+  }
+  return true;
+}
+
+int main()
+{
+  const s_design designs[] = {
+    {"de-emphasis 50us", lowpass, 50e-6, 0.0},
+    {"de-emphasis 75us", lowpass, 75e-6, 0.0},
+    {"ssb highpass 250Hz", highpass, 250.0, 0.707},
+    {"cw bandpass 400Hz", bandpass, 400.0, 4.0},
+    {"cw bandpass 1000Hz", bandpass, 1000.0, 4.0},
+    {"bass +14dB", low_shelf, 300.0, 14.0},
+    {"bass -16dB", low_shelf, 300.0, -16.0},
+    {"treble +14dB", high_shelf, 2500.0, 14.0},
+    {"treble -16dB", high_shelf, 2500.0, -16.0},
+  };
+  const double frequencies[] = {50.0, 150.0, 300.0, 400.0, 700.0, 1000.0, 2000.0, 2500.0, 4000.0, 6000.0};
+
+  bool pass = true;
+  for(const s_design &d : designs)
+  {
+    double worst_kernel_dB = 0.0, worst_design_dB = 0.0;
+    for(double frequency_Hz : frequencies)
+    {
+      const double ideal = reference_gain(d, frequency_Hz, false);
+      const double expected = reference_gain(d, frequency_Hz, true);
+      const double measured = measure_gain(d, frequency_Hz);
+
+      //relative error where the gain is significant, absolute error (re
+      //unity gain) in the stop band
+      const double kernel_dB = expected > 0.1 ? fabs(20.0 * log10(measured/expected)) : 0.0;
+      const double design_dB = ideal > 0.3 ? fabs(20.0 * log10(expected/ideal)) : 0.0;
+      const bool kernel_ok = expected > 0.1 ? kernel_dB < 0.05 : fabs(measured - expected) < 0.002;
+      const bool design_ok = ideal > 0.3 ? design_dB < 1.0 : fabs(expected - ideal) < 0.03;
+      worst_kernel_dB = kernel_dB > worst_kernel_dB ? kernel_dB : worst_kernel_dB;
+      worst_design_dB = design_dB > worst_design_dB ? design_dB : worst_design_dB;
+      if(!kernel_ok || !design_ok)
+      {
+        printf("%-24s %6.0f Hz ideal %.4f Q12 %.4f measured %.4f\n", d.name, frequency_Hz, ideal, expected, measured);
+        pass = false;
+      }
+    }
+    printf("%-24s worst error kernel %.3f dB, Q12 coefficients %.3f dB\n", d.name, worst_kernel_dB, worst_design_dB);
+    pass &= check_stability(d);
+    if(!check_update(d))
+    {
+      printf("%-24s output changed when the same design was re-applied\n", d.name);
+      pass = false;
+    }
+  }
+  return pass ? 0 : 1;
+}
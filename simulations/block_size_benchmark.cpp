@@ -0,0 +1,80 @@
+#include "../fft_filter.h"
+#include "../rx_definitions.h"
+#include "../utils.h"
+#include "../spectrum_averager.h"
+#include "../zoom_fft.h"
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+
+//Time the block based stages of the back end: the fft filter, the zoom FFT
+//and the spectrum averager. The spectrum and squelch measurements run once
+//every spectrum_frame_interval blocks, as in rx_dsp, so that their cost per
+//sample doesn't depend on the block size. The fft filter still runs once
+//per block, a smaller hop means more overlapping FFTs per sample. The per
+//sample stages (demodulation, AGC, audio filters) cost the same at every
+//block size.
+//Build with -DADC_BLOCK_SIZE=512, 1024 or 2048.
+int main()
+{
+  initialise_luts();
+  fft_filter filt;
+  static spectrum_averager averager;
+  static zoom_fft zoom;
+  zoom.set_stages(1);
+
+  s_filter_control fc;
+  fc.start_bin = 0;
+  fc.stop_bin = 32;
+  fc.fft_bin = 0;
+  fc.upper_sideband = true;
+  fc.lower_sideband = true;
+  fc.enable_auto_notch = false;
+
+  const uint32_t num_blocks = 20000;
+  int16_t capture[fft_size];
+  int16_t zoom_capture[zoom_fft_size];
+  uint16_t averaged[spectrum_averager_size];
+  uint32_t t = 0;
+  int32_t peak = 0;
+  double elapsed_s = 0.0;
+
+  for(uint32_t block = 0; block < num_blocks; ++block)
+  {
+    int16_t i[fft_hop_size];
+    int16_t q[fft_hop_size];
+    for(uint16_t idx = 0; idx < fft_hop_size; ++idx)
+    {
+      i[idx] = cos(2.0*M_PI*t/32.0)*1024;
+      q[idx] = sin(2.0*M_PI*t/32.0)*1024;
+      t++;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool spectrum_frame = block % spectrum_frame_interval == 0;
+    zoom.process_block(i, q, fft_hop_size, zoom_capture);
+    fc.capture = spectrum_frame;
+    filt.process_sample(i, q, fc, capture);
+    if(spectrum_frame)
+    {
+      averager.add_frame(capture);
+      averager.get_frame(average_slow, averaged);
+    }
+    elapsed_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    //steady state output amplitude should not depend on the block size
+    if(block > num_blocks/2)
+    {
+      for(uint16_t idx = 0; idx < new_fft_hop_size; ++idx)
+      {
+        peak = std::max(peak, (int32_t)i[idx]);
+      }
+    }
+  }
+
+  const double block_time_ms = 1e3*adc_block_size/adc_sample_rate;
+  const double us_per_block = 1e6*elapsed_s/num_blocks;
+  const double ns_per_sample = 1e9*elapsed_s/((double)num_blocks*adc_block_size);
+  printf("block size %4u, block time %.2f ms, %.2f us per block, %.2f ns per adc sample, output peak %i\n",
+         adc_block_size, block_time_ms, us_per_block, ns_per_sample, peak);
+}
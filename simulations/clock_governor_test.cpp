@@ -0,0 +1,93 @@
+#include "../clock_governor.h"
+#include <cstdio>
+#include <cmath>
+
+static uint32_t failures = 0;
+static void check(bool condition, const char *description)
+{
+  printf("%s: %s\n", condition ? "pass" : "FAIL", description);
+  if(!condition) failures++;
+}
+
+//run the governor at one update per block for a number of seconds
+static uint32_t run(clock_governor &governor, uint32_t &time_ms, uint32_t seconds, uint32_t busy_us, uint16_t battery_mV, bool heavy)
+{
+  const uint32_t block_us = 4267;
+  uint32_t changes = 0;
+  for(uint32_t t = 0; t < seconds*1000000u/block_us; ++t)
+  {
+    time_ms += block_us/1000u;
+    changes += governor.update(busy_us, block_us, battery_mV, heavy, time_ms);
+  }
+  return changes;
+}
+
+int main()
+{
+  //clock selection
+  const uint32_t frequencies[] = {125000000, 125142857, 125333333, 126000000, 126666666, 126857142, 127000000,
+                                  127200000, 127500000, 128000000, 128400000, 128571428, 129000000, 129333333,
+                                  129600000, 130000000, 130285714, 130500000, 130666666, 130800000, 131000000,
+                                  132000000, 133000000};
+  const uint8_t n = sizeof(frequencies)/sizeof(frequencies[0]);
+  uint32_t accurate_total = 0, low_total = 0, high_total = 0, within_target = 0, trials = 0;
+  for(double f = 500e3; f < 30e6; f += 77777.0)
+  {
+    const s_clock_choice accurate = choose_system_clock(frequencies, n, f, clock_most_accurate);
+    const s_clock_choice low = choose_system_clock(frequencies, n, f, clock_low_power);
+    const s_clock_choice high = choose_system_clock(frequencies, n, f, clock_high_performance);
+    accurate_total += frequencies[accurate.index]/1000000u;
+    low_total += frequencies[low.index]/1000000u;
+    high_total += frequencies[high.index]/1000000u;
+    const double best = fmin(fabs(accurate.lo_frequency_Hz - f - 4500.0), fabs(accurate.lo_frequency_Hz - f + 4500.0));
+    const s_clock_choice choices[] = {low, high};
+    for(const s_clock_choice &c : choices)
+    {
+      const double error = fmin(fabs(c.lo_frequency_Hz - f - 4500.0), fabs(c.lo_frequency_Hz - f + 4500.0));
+      within_target += error <= best + clock_lo_accuracy_Hz + 1.0;
+    }
+    trials++;
+  }
+  printf("mean clock MHz: accurate %u, low power %u, high performance %u\n",
+         accurate_total/trials, low_total/trials, high_total/trials);
+  check(low_total < accurate_total && high_total > accurate_total, "low and high preferences move the clock");
+  check(within_target == 2*trials, "all choices meet the LO accuracy target");
+
+  //policy
+  {
+    clock_governor governor;
+    uint32_t time_ms = 0;
+    run(governor, time_ms, 60, 1500, 5000, false);
+    check(governor.get_preference() == clock_most_accurate, "light load on usb power stays accurate");
+
+    run(governor, time_ms, 5, 3800, 5000, false);
+    check(governor.get_preference() == clock_high_performance, "overload selects high performance quickly");
+
+    run(governor, time_ms, 5, 2000, 5000, false);
+    check(governor.get_preference() == clock_high_performance, "relaxing waits for the dwell time");
+
+    run(governor, time_ms, 60, 2000, 5000, false);
+    check(governor.get_preference() == clock_most_accurate, "relaxes after the dwell time");
+
+    run(governor, time_ms, 60, 1500, 3900, false);
+    check(governor.get_preference() == clock_low_power, "idle on battery selects low power");
+
+    run(governor, time_ms, 5, 2800, 3900, true);
+    check(governor.get_preference() == clock_high_performance, "heavy features select high performance");
+
+    const uint32_t changes = run(governor, time_ms, 300, 2900, 5000, false);
+    check(changes <= 1, "no hunting near a threshold");
+
+    //decision log
+    check(governor.get_num_decisions() == 4, "each change is logged once");
+    for(uint32_t i = 0; i < governor.get_num_decisions(); ++i)
+    {
+      const s_governor_decision &d = governor.get_decision(i);
+      printf("  %6.1fs load %3u%% battery %4umV heavy %u preference %u\n",
+             d.time_ms/1000.0, d.load_percent, d.battery_mV, d.heavy_features, d.preference);
+    }
+  }
+
+  printf("%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
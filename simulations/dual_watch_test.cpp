@@ -0,0 +1,55 @@
+#include "../fft_filter.h"
+#include "../utils.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+//Feed a tone inside the dual watch pass band and check that the envelope
+//of the second channel is flat for odd and even bin shifts
+static bool flat_envelope(int16_t shift)
+{
+  fft_filter filt;
+  s_filter_control fc = {};
+  fc.start_bin = 0;
+  fc.stop_bin = 31;
+  fc.upper_sideband = true;
+  fc.lower_sideband = true;
+  s_filter_control second = fc;
+  second.fft_bin = shift;
+
+  const double tone_bin = shift + 5.3;
+  int16_t capture[fft_size];
+  double min_magnitude = 1e9, max_magnitude = 0.0;
+  uint32_t t = 0;
+  for(uint16_t block = 0; block < 64; ++block)
+  {
+    int16_t i[fft_hop_size], q[fft_hop_size];
+    int16_t second_i[new_fft_hop_size], second_q[new_fft_hop_size];
+    for(uint16_t idx = 0; idx < fft_hop_size; ++idx, ++t)
+    {
+      i[idx] = 1000*cos(2.0*M_PI*tone_bin*t/fft_size);
+      q[idx] = 1000*sin(2.0*M_PI*tone_bin*t/fft_size);
+    }
+    filt.process_sample(i, q, fc, capture, second_i, second_q, &second);
+    if(block <= fft_size/fft_hop_size) continue; //filter history still filling
+    for(uint16_t idx = 0; idx < new_fft_hop_size; ++idx)
+    {
+      const double magnitude = sqrt((double)second_i[idx]*second_i[idx] + (double)second_q[idx]*second_q[idx]);
+      min_magnitude = std::min(min_magnitude, magnitude);
+      max_magnitude = std::max(max_magnitude, magnitude);
+    }
+  }
+  const bool flat = min_magnitude > 0.9*max_magnitude;
+  printf("shift %3d: second channel magnitude %5.0f..%5.0f %s\n", shift, min_magnitude, max_magnitude, flat ? "flat" : "MODULATED");
+  return flat;
+}
+
+int main()
+{
+  initialise_luts();
+  printf("fft hop size %u\n", fft_hop_size);
+  bool pass = true;
+  for(int16_t shift : {0, 1, 2, 40, 41, 42, 43, -41, -40, 17}) pass &= flat_envelope(shift);
+  return pass ? 0 : 1;
+}
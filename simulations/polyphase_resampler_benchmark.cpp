@@ -0,0 +1,70 @@
+#include "../polyphase_resampler.h"
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <complex>
+
+//Time the 15kHz to 48kHz resampler on 128 sample blocks (one DSP block at
+//the default adc block size) and measure the level of a tone and of its
+//images in the 48kHz output.
+static double tone_level_dB(const std::vector<double> &x, double frequency, double rate)
+{
+  std::complex<double> sum = 0.0;
+  for(size_t n = 0; n < x.size(); ++n)
+  {
+    const double window = 0.5 - 0.5*cos(2.0*M_PI*n/x.size());
+    sum += x[n]*window*std::polar(1.0, -2.0*M_PI*frequency*n/rate);
+  }
+  return 20.0*log10(2.0*std::abs(sum)/(0.5*x.size()));
+}
+
+int main()
+{
+  const double input_rate = 15000.0;
+  const double output_rate = 48000.0;
+  const uint16_t block_size = 128;
+  const uint32_t num_blocks = 20000;
+
+  polyphase_resampler resampler;
+  int16_t in[block_size];
+  int16_t out[block_size*16/5 + 1];
+  uint32_t n = 0;
+  uint64_t total_out = 0;
+  double elapsed_s = 0.0;
+  for(uint32_t block = 0; block < num_blocks; ++block)
+  {
+    for(uint16_t idx = 0; idx < block_size; ++idx, ++n) in[idx] = 16384*sin(2.0*M_PI*1000.0*n/input_rate);
+    const auto start = std::chrono::steady_clock::now();
+    total_out += resampler.process_block(in, block_size, out);
+    elapsed_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  printf("%u outputs per %u inputs, %.0f ns per block\n", (unsigned)(total_out/num_blocks), block_size, 1e9*elapsed_s/num_blocks);
+
+  //frequency response and image rejection
+  bool pass = total_out == (uint64_t)num_blocks*block_size*16/5;
+  const double tones[] = {300.0, 1000.0, 3000.0, 5000.0};
+  for(double tone : tones)
+  {
+    resampler.reset();
+    std::vector<double> output;
+    n = 0;
+    for(uint32_t block = 0; block < 64; ++block)
+    {
+      for(uint16_t idx = 0; idx < block_size; ++idx, ++n) in[idx] = 16384*sin(2.0*M_PI*tone*n/input_rate);
+      const uint16_t num_out = resampler.process_block(in, block_size, out);
+      if(block >= 2) output.insert(output.end(), out, out + num_out);
+    }
+    const double level = tone_level_dB(output, tone, output_rate) - 20.0*log10(16384.0);
+    double worst_image = -200.0;
+    for(int k = 1; k < 4; ++k)
+    {
+      worst_image = std::max(worst_image, tone_level_dB(output, k*input_rate - tone, output_rate) - 20.0*log10(16384.0));
+      if(k*input_rate + tone < output_rate/2) worst_image = std::max(worst_image, tone_level_dB(output, k*input_rate + tone, output_rate) - 20.0*log10(16384.0));
+    }
+    printf("%5.0f Hz: gain %+5.2f dB, worst image %6.1f dB\n", tone, level, worst_image);
+    pass = pass && fabs(level) < 0.5 && worst_image < -60.0;
+  }
+  printf("%s\n", pass ? "pass" : "fail");
+  return pass ? 0 : 1;
+}
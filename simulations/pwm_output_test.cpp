@@ -0,0 +1,76 @@
+#include "../pwm_output.h"
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+//Measure the in-band SNR of the PWM output stage. A 1kHz tone is converted
+//to PWM levels, the difference from the ideal (unquantised) levels is low
+//pass filtered to the audio band and compared with the tone.
+//Build with and without -DPWM_NOISE_SHAPING to compare.
+int main()
+{
+  const double audio_rate = adc_sample_rate/decimation_rate;
+  const double pwm_rate = audio_rate*interpolation_rate;
+  const double tone_Hz = 1000.0;
+  const double band_Hz = 5000.0;
+  const uint32_t pwm_max = 520;
+  const uint32_t num_samples = 30000;
+
+  pwm_output output;
+  output.set_pwm_max(pwm_max);
+
+  std::vector<double> error;
+  std::vector<double> ideal;
+  double last_level = 0.0;
+  for(uint32_t n = 0; n < num_samples; ++n)
+  {
+    const int16_t audio = 16384*sin(2.0*M_PI*tone_Hz*n/audio_rate);
+    int16_t pwm[interpolation_rate];
+    output.process_sample(audio, pwm);
+
+    //the ideal output is the same linear interpolation without quantisation
+    const double level = (audio + 32768.0)*pwm_max/65536.0;
+    for(uint16_t subsample = 0; subsample < interpolation_rate; ++subsample)
+    {
+      const double interpolated = last_level + (level - last_level)*(subsample + 1)/interpolation_rate;
+      ideal.push_back(interpolated);
+      error.push_back(pwm[subsample] - interpolated);
+    }
+    last_level = level;
+  }
+
+  //windowed sinc low pass filter
+  const int taps = 1023;
+  std::vector<double> h(taps);
+  for(int i = 0; i < taps; ++i)
+  {
+    const double t = i - (taps - 1)/2.0;
+    const double sinc = t == 0 ? 2.0*band_Hz/pwm_rate : sin(2.0*M_PI*band_Hz*t/pwm_rate)/(M_PI*t);
+    const double window = 0.42 - 0.5*cos(2.0*M_PI*i/(taps - 1)) + 0.08*cos(4.0*M_PI*i/(taps - 1));
+    h[i] = sinc*window;
+  }
+
+  //skip the start up transient, DC offsets are blocked by the output capacitor
+  double noise_power = 0.0;
+  double signal_power = 0.0;
+  double mean = 0.0;
+  double error_mean = 0.0;
+  const uint32_t start = 4*taps;
+  for(uint32_t n = start; n < error.size(); ++n)
+  {
+    mean += ideal[n];
+    error_mean += error[n];
+  }
+  mean /= error.size() - start;
+  error_mean /= error.size() - start;
+  for(uint32_t n = start; n < error.size(); ++n)
+  {
+    double filtered = 0.0;
+    for(int i = 0; i < taps; ++i) filtered += h[i]*(error[n - i] - error_mean);
+    noise_power += filtered*filtered;
+    signal_power += (ideal[n] - mean)*(ideal[n] - mean);
+  }
+
+  printf("in-band SNR %.1f dB (%.1f effective bits)\n", 10.0*log10(signal_power/noise_power),
+         (10.0*log10(signal_power/noise_power) - 1.76)/6.02);
+}
@@ -0,0 +1,101 @@
+#include "../fft_filter.h"
+#include "../snr_squelch.h"
+#include "../utils.h"
+#include "../cic_corrections.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+
+//gaussian noise with the droop of the CIC decimator, so that it is flat
+//after the cic correction like the receiver noise floor
+struct shaped_noise
+{
+  std::mt19937 rng;
+  std::normal_distribution<double> normal{0.0, 1.0};
+  double taps[fft_size];
+  double history[fft_size] = {0};
+  uint16_t position = 0;
+
+  shaped_noise(int seed) : rng(seed)
+  {
+    for(uint16_t t = 0; t < fft_size; ++t)
+    {
+      double sum = 0.0;
+      for(int16_t k = -128; k < 128; ++k) sum += 256.0/cic_correction[abs(k)]*cos(2.0*M_PI*k*(t-128)/fft_size);
+      taps[t] = sum/fft_size*(0.5 - 0.5*cos(2.0*M_PI*t/fft_size));
+    }
+  }
+
+  double next(double sigma)
+  {
+    history[position] = normal(rng)*sigma;
+    double sum = 0.0;
+    for(uint16_t t = 0; t < fft_size; ++t) sum += taps[t]*history[(position - t) & (fft_size - 1)];
+    position = (position + 1) & (fft_size - 1);
+    return sum;
+  }
+};
+
+//feed noise, then noise and a tone, then noise again and record whether the
+//squelch is open at the end of each period
+static bool run(uint16_t stop_bin, float threshold_dB, double tone_amplitude, bool expect_open)
+{
+  fft_filter filt;
+  s_filter_control fc = {};
+  fc.start_bin = 0;
+  fc.stop_bin = stop_bin;
+  fc.upper_sideband = true;
+  fc.lower_sideband = true;
+  fc.capture = true;
+  snr_squelch squelch;
+  squelch.set_threshold_dB(threshold_dB);
+
+  shaped_noise noise_i(1), noise_q(2);
+  int16_t capture[fft_size];
+  bool open[3];
+  int16_t snr_dB[3];
+  uint32_t t = 0;
+  for(uint8_t period = 0; period < 3; ++period)
+  {
+    uint16_t opened = 0;
+    const uint16_t frames = 400;
+    for(uint16_t frame = 0; frame < frames; ++frame)
+    {
+      int16_t i[fft_hop_size], q[fft_hop_size];
+      for(uint16_t idx = 0; idx < fft_hop_size; ++idx, ++t)
+      {
+        const double tone = period == 1 ? tone_amplitude : 0.0;
+        i[idx] = noise_i.next(1000.0) + tone*cos(2.0*M_PI*5.3*t/fft_size);
+        q[idx] = noise_q.next(1000.0) + tone*sin(2.0*M_PI*5.3*t/fft_size);
+      }
+      filt.process_sample(i, q, fc, capture);
+      squelch.update(fc.signal_level, fc.noise_level);
+      if(frame >= frames/2 && squelch.is_open()) opened++;
+    }
+    //open or closed for the whole second half of the period
+    open[period] = opened == 200;
+    if(opened != 0 && opened != 200) open[period] = !expect_open;
+    snr_dB[period] = squelch.get_snr_dB();
+  }
+
+  const bool pass = !open[0] && open[1] == expect_open && !open[2];
+  printf("stop bin %2u, threshold %4.1f dB, tone %5.0f: SNR %3d/%3d/%3d dB, squelch %s/%s/%s %s\n",
+         stop_bin, threshold_dB, tone_amplitude, snr_dB[0], snr_dB[1], snr_dB[2],
+         open[0] ? "open" : "closed", open[1] ? "open" : "closed", open[2] ? "open" : "closed",
+         pass ? "" : "FAIL");
+  return pass;
+}
+
+int main()
+{
+  initialise_luts();
+  bool pass = true;
+  for(uint16_t stop_bin : {19, 31, 43})
+  {
+    pass &= run(stop_bin, 3.0f, 0.0, false);
+    pass &= run(stop_bin, 6.0f, 10000.0, true);
+    pass &= run(stop_bin, 20.0f, 10000.0, false);
+  }
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+from subprocess import run
+
+# the Q12 biquad kernel must match a double precision reference and be stable
+run(["g++", "-O2", "-DSIMULATION=true", "../biquad_filter.cpp", "biquad_test.cpp", "-o", "biquad_test"], check=True)
+output = run("./biquad_test", capture_output=True)
+print(output.stdout.decode("utf8").strip())
+print("pass" if output.returncode == 0 else "fail")
@@ -0,0 +1,5 @@
+from subprocess import run
+
+run(["g++", "-DSIMULATION=true", "../clock_governor.cpp", "clock_governor_test.cpp", "-o", "clock_governor_test"], check=True)
+output = run("./clock_governor_test", capture_output=True)
+print(output.stdout.decode("utf8").strip())
@@ -0,0 +1,11 @@
+from subprocess import run
+
+# the whole bin shift needs a phase correction at every supported hop size
+passed = True
+for block_size in [2048, 1024, 512]:
+    run(["g++", "-O2", "-DSIMULATION=true", "-DADC_BLOCK_SIZE=%u" % block_size, "../utils.cpp", "../fft.cpp",
+         "../fft_filter.cpp", "../cic_corrections.cpp", "dual_watch_test.cpp", "-o", "dual_watch_test"], check=True)
+    output = run("./dual_watch_test", capture_output=True)
+    print(output.stdout.decode("utf8").strip())
+    passed &= output.returncode == 0
+print("pass" if passed else "fail")
@@ -0,0 +1,7 @@
+from subprocess import run
+
+for name, flags in [("plain", []), ("noise shaped", ["-DPWM_NOISE_SHAPING"])]:
+  run(["g++", "-O2", "-DSIMULATION=true"] + flags +
+      ["../pwm_output.cpp", "pwm_output_test.cpp", "-o", "pwm_output_test"], check=True)
+  output = run("./pwm_output_test", capture_output=True)
+  print("%-12s %s"%(name, output.stdout.decode("utf8").strip()))
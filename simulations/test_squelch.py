@@ -0,0 +1,8 @@
+from subprocess import run
+
+# noise alone must keep the snr squelch closed, a tone must open it
+run(["g++", "-O2", "-DSIMULATION=true", "../utils.cpp", "../fft.cpp", "../fft_filter.cpp", "../cic_corrections.cpp",
+     "../snr_squelch.cpp", "squelch_test.cpp", "-o", "squelch_test"], check=True)
+output = run("./squelch_test", capture_output=True)
+print(output.stdout.decode("utf8").strip())
+print("pass" if output.returncode == 0 else "fail")
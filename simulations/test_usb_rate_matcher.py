@@ -0,0 +1,7 @@
+from subprocess import run
+
+run(["g++", "-O2", "-DSIMULATION=true", "../usb_rate_matcher.cpp", "usb_rate_matcher_test.cpp",
+     "-o", "usb_rate_matcher_test"], check=True)
+output = run("./usb_rate_matcher_test", capture_output=True)
+print(output.stdout.decode("utf8").strip())
+print("pass" if output.returncode == 0 else "fail")
@@ -0,0 +1,115 @@
+#include "../usb_rate_matcher.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+//Simulate the USB buffer with the host clock offset from the adc clock.
+//Blocks of 128 samples are added at the adc rate, the host removes 15
+//samples every 1ms of its own clock. Report drops after settling.
+static void simulate(double host_ppm)
+{
+  const double audio_rate = 15000.0;
+  const uint16_t block_size = 128;
+  const uint16_t capacity = 258;
+  const double block_period = block_size/audio_rate;
+  const double packet_period = 1e-3/(1.0 + host_ppm*1e-6);
+  const double duration = 1800.0;
+  const double settle = 60.0;
+
+  usb_rate_matcher matcher;
+  matcher.set_target_level((capacity - block_size)/2);
+
+  int32_t level = 0;
+  uint32_t overflows = 0, underflows = 0;
+  int32_t min_level = capacity, max_level = 0;
+  double next_block = 0.0, next_packet = 0.0;
+  int16_t in[block_size] = {0};
+  int16_t out[2 * (block_size + 2)];
+  while(next_block < duration)
+  {
+    const bool settled = next_block > settle;
+    if(next_block < next_packet)
+    {
+      matcher.update(level);
+      if(settled)
+      {
+        min_level = std::min(min_level, level);
+        max_level = std::max(max_level, level);
+      }
+      level += matcher.process_block(in, in, block_size, out);
+      if(level > capacity)
+      {
+        if(settled) overflows++;
+        level = capacity;
+      }
+      next_block += block_period;
+    }
+    else
+    {
+      level -= 15;
+      if(level < 0)
+      {
+        if(settled) underflows++;
+        level = 0;
+      }
+      next_packet += packet_period;
+    }
+  }
+  printf("host %+6.0f ppm: ratio %+5d ppm, level %3d-%3d, overflows %u, underflows %u\n",
+         host_ppm, (int)matcher.get_ratio_ppm(), (int)min_level, (int)max_level, overflows, underflows);
+  if(overflows || underflows || abs(matcher.get_ratio_ppm() - host_ppm) > 20) exit(1);
+}
+
+//Resample a 1kHz tone with a fixed ratio and compare with the ideal, the
+//right channel carries the inverted tone
+static void quality()
+{
+  const double audio_rate = 15000.0;
+  const double tone_Hz = 1000.0;
+  const double ratio_ppm = 1000.0;
+  usb_rate_matcher matcher;
+  matcher.set_target_level(100);
+
+  //drive the controller to a constant ratio with an empty buffer
+  while(matcher.get_ratio_ppm() < ratio_ppm) matcher.update(0);
+  const double step = 1.0 - floor(matcher.get_ratio_ppm()*16777216.0/1e6)/16777216.0;
+
+  int16_t left[128], right[128];
+  int16_t out[2 * 130];
+  double signal = 0.0, error = 0.0;
+  uint32_t n_in = 0, n_out = 0;
+  for(uint16_t block = 0; block < 1000; ++block)
+  {
+    for(uint16_t idx = 0; idx < 128; ++idx, ++n_in)
+    {
+      left[idx] = 16384*sin(2.0*M_PI*tone_Hz*n_in/audio_rate);
+      right[idx] = -left[idx];
+    }
+    const uint16_t num_out = matcher.process_block(left, right, 128, out);
+    for(uint16_t idx = 0; idx < num_out; ++idx, ++n_out)
+    {
+      //outputs lag the input by two samples
+      const double t = n_out*step - 2.0;
+      const double ideal = 16384*sin(2.0*M_PI*tone_Hz*t/audio_rate);
+      if(block > 10)
+      {
+        signal += 2*ideal*ideal;
+        error += (out[2*idx] - ideal)*(out[2*idx] - ideal);
+        error += (out[2*idx+1] + ideal)*(out[2*idx+1] + ideal);
+      }
+    }
+  }
+  const double snr = 10.0*log10(signal/error);
+  printf("1kHz tone at %+d ppm: SNR %.1f dB\n", (int)matcher.get_ratio_ppm(), snr);
+  if(snr < 50.0) exit(1);
+}
+
+int main()
+{
+  const double offsets[] = {0.0, 100.0, -300.0, 500.0, -1000.0, 1500.0};
+  for(double offset : offsets) simulate(offset);
+  quality();
+  return 0;
+}
@@ -0,0 +1,64 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: snr_squelch.cpp
+// description: squelch on the ratio of in-band signal to out-of-band noise
+// License: MIT
+//
+
+#include "snr_squelch.h"
+#include <math.h>
+
+#ifndef SIMULATION
+#include "pico/stdlib.h"
+#endif
+
+snr_squelch::snr_squelch()
+{
+  set_threshold_dB(3.0f);
+  reset();
+}
+
+void snr_squelch::set_threshold_dB(float threshold_dB)
+{
+  //half the threshold at most, so that a 3dB setting closes at 1.5dB
+  const float hysteresis_dB = fminf(3.0f, threshold_dB/2.0f);
+  open_ratio = 256.0f*powf(10.0f, threshold_dB/20.0f);
+  close_ratio = 256.0f*powf(10.0f, (threshold_dB - hysteresis_dB)/20.0f);
+}
+
+void snr_squelch::reset()
+{
+  signal_avg = 0u;
+  noise_avg = 0u;
+  open = false;
+}
+
+#ifndef SIMULATION
+bool __not_in_flash_func(snr_squelch::update)(uint16_t signal_level, uint16_t noise_level)
+#else
+bool snr_squelch::update(uint16_t signal_level, uint16_t noise_level)
+#endif
+{
+  signal_avg = signal_avg - (signal_avg >> 3) + signal_level;
+  noise_avg = noise_avg - (noise_avg >> 3) + noise_level;
+
+  //open and close at different ratios (hysteresis) to avoid chattering
+  const uint32_t ratio = open ? close_ratio : open_ratio;
+  open = ((uint64_t)signal_avg << 8) >= ((uint64_t)noise_avg * ratio);
+  return open;
+}
+
+int16_t snr_squelch::get_snr_dB()
+{
+  if(signal_avg == 0 || noise_avg == 0)
+  {
+    return 0;
+  }
+  return roundf(20.0f*log10f((float)signal_avg/noise_avg));
+}
@@ -0,0 +1,40 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: snr_squelch.h
+// description: squelch on the ratio of in-band signal to out-of-band noise
+// License: MIT
+//
+
+#ifndef SNR_SQUELCH_H
+#define SNR_SQUELCH_H
+#include <stdint.h>
+
+//Levels are the average magnitude per FFT bin measured by the fft filter on
+//each capture frame. The squelch opens at the threshold and closes up to 3dB
+//below it, but never below 0dB where noise alone would hold it open.
+class snr_squelch
+{
+  uint16_t open_ratio; //8 fractional bits
+  uint16_t close_ratio;
+  uint32_t signal_avg; //8x the level
+  uint32_t noise_avg;
+  bool open;
+
+  public:
+  snr_squelch();
+  void set_threshold_dB(float threshold_dB);
+  void reset();
+
+  //smooth the levels of one capture frame, returns true when open
+  bool update(uint16_t signal_level, uint16_t noise_level);
+  bool is_open(){return open;}
+  int16_t get_snr_dB();
+};
+
+#endif
@@ -0,0 +1,123 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: spectrum_averager.cpp
+// description: video averaging of spectrum captures at the FFT block rate
+// License: MIT
+//
+
+#include "spectrum_averager.h"
+#include <algorithm>
+
+#ifndef SIMULATION
+#include "pico/stdlib.h"
+#endif
+
+//for frames at 234Hz
+static const uint8_t fast_shift_234Hz = 3u;
+static const uint8_t slow_shift_234Hz = 6u;
+static const uint8_t very_slow_shift_234Hz = 9u;
+static const uint8_t peak_decay_shift_234Hz = 8u;
+static const uint8_t min_recovery_shift_234Hz = 8u;
+static const uint8_t linear_length_shift_234Hz = 8u;
+
+spectrum_averager::spectrum_averager()
+{
+  set_frame_rate_shift(0);
+}
+
+//Doubling the frame rate doubles the number of frames in a time constant.
+//When frames are slower than the time constant, the shift bottoms out at 0
+//and each frame replaces the average.
+static uint8_t scale_shift(uint8_t shift, int8_t frame_rate_shift)
+{
+  return std::max((int8_t)shift + frame_rate_shift, 0);
+}
+
+void spectrum_averager::set_frame_rate_shift(int8_t shift)
+{
+  fast_shift = scale_shift(fast_shift_234Hz, shift);
+  slow_shift = scale_shift(slow_shift_234Hz, shift);
+  very_slow_shift = scale_shift(very_slow_shift_234Hz, shift);
+  peak_decay_shift = scale_shift(peak_decay_shift_234Hz, shift);
+  min_recovery_shift = scale_shift(min_recovery_shift_234Hz, shift);
+  linear_length = 1u << scale_shift(linear_length_shift_234Hz, shift);
+  reset();
+}
+
+void spectrum_averager::reset()
+{
+  for(uint16_t i=0; i<spectrum_averager_size; i++)
+  {
+    fast[i] = 0u;
+    slow[i] = 0u;
+    very_slow[i] = 0u;
+    peak[i] = 0u;
+    minimum[i] = UINT32_MAX;
+    linear_sum[i] = 0u;
+    linear[i] = 0u;
+  }
+  linear_frames = 0u;
+}
+
+#ifndef SIMULATION
+void __not_in_flash_func(spectrum_averager::add_frame)(const int16_t magnitudes[])
+#else
+void spectrum_averager::add_frame(const int16_t magnitudes[])
+#endif
+{
+  for(uint16_t i=0; i<spectrum_averager_size; i++)
+  {
+    const uint16_t magnitude = magnitudes[i];
+    const uint32_t scaled = (uint32_t)magnitude << 8;
+
+    //exponential, the accumulators are unsigned so step up and down separately
+    if(scaled > fast[i]) fast[i] += (scaled - fast[i]) >> fast_shift;
+    else fast[i] -= (fast[i] - scaled) >> fast_shift;
+    if(scaled > slow[i]) slow[i] += (scaled - slow[i]) >> slow_shift;
+    else slow[i] -= (slow[i] - scaled) >> slow_shift;
+    if(scaled > very_slow[i]) very_slow[i] += (scaled - very_slow[i]) >> very_slow_shift;
+    else very_slow[i] -= (very_slow[i] - scaled) >> very_slow_shift;
+
+    //peak hold, instant attack with a slow decay
+    peak[i] = std::max(scaled, peak[i] - (peak[i] >> peak_decay_shift));
+
+    //minimum hold, instant release with a slow recovery
+    if(minimum[i] == UINT32_MAX) minimum[i] = scaled;
+    minimum[i] = std::min(scaled, minimum[i] + (minimum[i] >> min_recovery_shift) + 1u);
+
+    //linear
+    linear_sum[i] += magnitude;
+  }
+
+  if(++linear_frames >= linear_length)
+  {
+    for(uint16_t i=0; i<spectrum_averager_size; i++)
+    {
+      linear[i] = linear_sum[i] / linear_length;
+      linear_sum[i] = 0u;
+    }
+    linear_frames = 0u;
+  }
+}
+
+void spectrum_averager::get_frame(uint8_t mode, uint16_t magnitudes[])
+{
+  for(uint16_t i=0; i<spectrum_averager_size; i++)
+  {
+    switch(mode)
+    {
+      case average_slow:      magnitudes[i] = slow[i] >> 8; break;
+      case average_very_slow: magnitudes[i] = very_slow[i] >> 8; break;
+      case average_linear:    magnitudes[i] = linear[i]; break;
+      case average_peak_hold: magnitudes[i] = peak[i] >> 8; break;
+      case average_min_hold:  magnitudes[i] = minimum[i] >> 8; break;
+      default:                magnitudes[i] = fast[i] >> 8; break;
+    }
+  }
+}
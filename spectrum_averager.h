@@ -0,0 +1,71 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: spectrum_averager.h
+// description: video averaging of spectrum captures at the FFT block rate
+// License: MIT
+//
+
+#ifndef SPECTRUM_AVERAGER_H
+#define SPECTRUM_AVERAGER_H
+#include <stdint.h>
+
+static const uint16_t spectrum_averager_size = 256u;
+
+//averaging modes, as stored in the settings
+enum e_spectrum_average
+{
+  average_fast,      //exponential, about 34ms
+  average_slow,      //exponential, about 270ms
+  average_very_slow, //exponential, about 2.2s
+  average_linear,    //block mean over about 1.1s
+  average_peak_hold, //peak hold with about 1s decay
+  average_min_hold,  //minimum hold with slow recovery
+  num_spectrum_averages
+};
+
+//Each mode has its own accumulator and all of them are updated with every
+//frame, so switching modes shows the accumulated history immediately.
+//The time constants above are for frames at 234Hz, they are rescaled when
+//the frame rate changes.
+class spectrum_averager
+{
+  uint8_t fast_shift;
+  uint8_t slow_shift;
+  uint8_t very_slow_shift;
+  uint8_t peak_decay_shift;
+  uint8_t min_recovery_shift;
+  uint16_t linear_length;
+
+  //magnitudes with 8 fractional bits
+  uint32_t fast[spectrum_averager_size];
+  uint32_t slow[spectrum_averager_size];
+  uint32_t very_slow[spectrum_averager_size];
+  uint32_t peak[spectrum_averager_size];
+  uint32_t minimum[spectrum_averager_size];
+
+  //linear average is a block mean, the last complete mean is held
+  uint32_t linear_sum[spectrum_averager_size];
+  uint16_t linear[spectrum_averager_size];
+  uint16_t linear_frames;
+
+  public:
+  spectrum_averager();
+  void reset();
+
+  //frames arrive at 234Hz * 2^shift
+  void set_frame_rate_shift(int8_t shift);
+
+  //add one frame of magnitudes, called on core 1 as each FFT block completes
+  void add_frame(const int16_t magnitudes[]);
+
+  //averaged magnitudes for the chosen mode
+  void get_frame(uint8_t mode, uint16_t magnitudes[]);
+};
+
+#endif
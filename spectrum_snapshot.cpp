@@ -0,0 +1,56 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: spectrum_snapshot.cpp
+// description: lock-free handoff of spectrum frames from core 1 to core 0
+// License: MIT
+//
+
+#include "spectrum_snapshot.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+spectrum_snapshot::spectrum_snapshot()
+{
+  sequence = 0u;
+  published = 0u;
+  dropped = 0u;
+  last_read_sequence = 0u;
+  for(uint16_t i=0; i<spectrum_snapshot_size; i++) frame[i] = 0;
+  filter_control = {};
+}
+
+void __not_in_flash_func(spectrum_snapshot::publish)(const int16_t capture[], const s_filter_control &capture_filter_control)
+{
+  sequence = sequence + 1u; //odd, write in progress
+  __dmb();
+  for(uint16_t i=0; i<spectrum_snapshot_size; i++) frame[i] = capture[i];
+  filter_control = capture_filter_control;
+  __dmb();
+  sequence = sequence + 1u; //even, frame complete
+  published = published + 1u;
+}
+
+bool spectrum_snapshot::read(int16_t capture[], s_filter_control &capture_filter_control)
+{
+  uint32_t start;
+  do
+  {
+    start = sequence;
+    __dmb();
+    for(uint16_t i=0; i<spectrum_snapshot_size; i++) capture[i] = frame[i];
+    capture_filter_control = filter_control;
+    __dmb();
+  } while((start & 1u) || (start != sequence));
+
+  //frames published since the last read that were never seen
+  const uint32_t new_frames = (start - last_read_sequence) >> 1;
+  last_read_sequence = start;
+  if(new_frames > 1u) dropped = dropped + new_frames - 1u;
+  return new_frames != 0u;
+}
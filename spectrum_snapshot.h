@@ -0,0 +1,48 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: spectrum_snapshot.h
+// description: lock-free handoff of spectrum frames from core 1 to core 0
+// License: MIT
+//
+
+#ifndef SPECTRUM_SNAPSHOT_H
+#define SPECTRUM_SNAPSHOT_H
+#include <stdint.h>
+#include "fft_filter.h"
+
+static const uint16_t spectrum_snapshot_size = 256u;
+
+//A sequence lock with a single writer. The writer (core 1) never waits,
+//the sequence is odd while a frame is being written. The reader (core 0)
+//copies the frame and tries again if the sequence changed underneath it.
+class spectrum_snapshot
+{
+  volatile uint32_t sequence;
+  int16_t frame[spectrum_snapshot_size];
+  s_filter_control filter_control;
+
+  //frame counters, published is written by core 1, the rest by core 0
+  volatile uint32_t published;
+  volatile uint32_t dropped;
+  uint32_t last_read_sequence;
+
+  public:
+  spectrum_snapshot();
+
+  //core 1: make a new frame available
+  void publish(const int16_t capture[], const s_filter_control &capture_filter_control);
+
+  //core 0: copy the latest frame, returns false if there is no new frame since the last read
+  bool read(int16_t capture[], s_filter_control &capture_filter_control);
+
+  uint32_t get_published(){return published;}
+  uint32_t get_dropped(){return dropped;}
+};
+
+#endif
@@ -0,0 +1,119 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: task_scheduler.cpp
+// description: cooperative deadline scheduler for the core 0 tasks
+// License: MIT
+//
+
+#include "task_scheduler.h"
+#include "pico/stdlib.h"
+#include "pico/time.h"
+
+task_scheduler::task_scheduler()
+{
+  num_tasks = 0;
+  start_us = time_us_64();
+  idle_us = 0;
+}
+
+int8_t task_scheduler::add_task(const char *name, void (*function)(void *context), void *context, uint32_t period_us, uint32_t deadline_us, uint8_t priority)
+{
+  if(num_tasks == scheduler_max_tasks) return -1;
+  s_task &task = tasks[num_tasks];
+  task.name = name;
+  task.function = function;
+  task.context = context;
+  task.period_us = period_us;
+  task.deadline_us = deadline_us;
+  task.priority = priority;
+  task.release_us = time_us_32();
+  task.runs = 0;
+  task.overruns = 0;
+  task.busy_us = 0;
+  task.max_us = 0;
+  return num_tasks++;
+}
+
+void task_scheduler::run_task(s_task &task, uint32_t release_us)
+{
+  const uint32_t start = time_us_32();
+  task.function(task.context);
+  const uint32_t end = time_us_32();
+
+  const uint32_t elapsed = end - start;
+  task.runs++;
+  task.busy_us += elapsed;
+  task.max_us = elapsed > task.max_us ? elapsed : task.max_us;
+  if(end - release_us > task.deadline_us) task.overruns++;
+}
+
+void task_scheduler::run_once()
+{
+  //event driven tasks are polled between every periodic task
+  for(uint8_t idx=0; idx<num_tasks; ++idx)
+  {
+    if(!tasks[idx].period_us) run_task(tasks[idx], time_us_32());
+  }
+
+  //pick the released task with the highest priority, then earliest deadline
+  const uint32_t now = time_us_32();
+  s_task *next = 0;
+  int32_t next_deadline = 0;
+  int32_t sleep_us = INT32_MAX;
+  for(uint8_t idx=0; idx<num_tasks; ++idx)
+  {
+    s_task &task = tasks[idx];
+    if(!task.period_us) continue;
+    const int32_t until_release = (int32_t)(task.release_us - now);
+    if(until_release > 0)
+    {
+      sleep_us = until_release < sleep_us ? until_release : sleep_us;
+      continue;
+    }
+    const int32_t until_deadline = until_release + (int32_t)task.deadline_us;
+    if(!next || task.priority < next->priority || (task.priority == next->priority && until_deadline < next_deadline))
+    {
+      next = &task;
+      next_deadline = until_deadline;
+    }
+  }
+
+  if(next)
+  {
+    const uint32_t release_us = next->release_us;
+    run_task(*next, release_us);
+
+    //keep the phase, but don't try to catch up on missed periods
+    next->release_us += next->period_us;
+    if((int32_t)(time_us_32() - next->release_us) > 0) next->release_us = time_us_32();
+    return;
+  }
+
+  //nothing ready, sleep until the next release, interrupts and SEV from
+  //the other core also wake the core
+  if(sleep_us != INT32_MAX)
+  {
+    const uint32_t sleep_start = time_us_32();
+    best_effort_wfe_or_timeout(make_timeout_time_us(sleep_us));
+    idle_us += time_us_32() - sleep_start;
+  }
+}
+
+void task_scheduler::run()
+{
+  while(1)
+  {
+    run_once();
+  }
+}
+
+uint64_t task_scheduler::get_elapsed_us()
+{
+  return time_us_64() - start_us;
+}
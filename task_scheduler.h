@@ -0,0 +1,62 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: task_scheduler.h
+// description: cooperative deadline scheduler for the core 0 tasks
+// License: MIT
+//
+
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+#include <stdint.h>
+
+static const uint8_t scheduler_max_tasks = 8u;
+
+struct s_task
+{
+  const char *name;
+  void (*function)(void *context);
+  void *context;
+  uint32_t period_us;   //0 runs on every pass, woken by events
+  uint32_t deadline_us; //after release, an overrun is counted when missed
+  uint8_t priority;     //0 is highest
+  uint32_t release_us;
+
+  //statistics
+  uint32_t runs;
+  uint32_t overruns;
+  uint64_t busy_us;
+  uint32_t max_us;
+};
+
+//Periodic tasks that have been released run highest priority first, then
+//earliest deadline first. Tasks never pre-empt each other, so long tasks
+//should be broken into steps. When nothing is ready the core sleeps (WFE)
+//until the next release or an event.
+class task_scheduler
+{
+  s_task tasks[scheduler_max_tasks];
+  uint8_t num_tasks;
+  uint64_t start_us;
+  uint64_t idle_us;
+
+  void run_task(s_task &task, uint32_t release_us);
+
+  public:
+  task_scheduler();
+  int8_t add_task(const char *name, void (*function)(void *context), void *context, uint32_t period_us, uint32_t deadline_us, uint8_t priority);
+  void run_once();
+  void run();
+
+  uint8_t get_num_tasks(){return num_tasks;}
+  const s_task &get_task(uint8_t index){return tasks[index];}
+  uint64_t get_idle_us(){return idle_us;}
+  uint64_t get_elapsed_us();
+};
+
+#endif
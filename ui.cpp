@@ -376,7 +376,10 @@ void ui::renderpage_original(rx_status & status, rx & receiver)
       u8g2_DrawRBox(&u8g2, i * (seg_w + 1) + seg_x + 2, seg_y+2, seg_w, seg_h, 2);
     }
   }
-  u8g2_DrawVLine(&u8g2, settings[idx_squelch] * (seg_w + 1) + seg_x + 2, seg_y, seg_h+4);
+  if(settings[idx_squelch] < squelch_snr_first)
+  {
+    u8g2_DrawVLine(&u8g2, settings[idx_squelch] * (seg_w + 1) + seg_x + 2, seg_y, seg_h+4);
+  }
 
   const char smeter[13][6] = {"S0", "S1", "S2", "S3", "S4", "S5", "S6", "S7", "S8", "S9", "+10", "+20", "+30"};
   u8g2_SetFont(&u8g2, u8g2_font_9x15_tf);
@@ -440,9 +443,20 @@ void ui::renderpage_status(rx_status & status, rx & receiver)
   const float temp = 27.0f - (temp_voltage - 0.706f)/0.001721f;
   const float block_time = (float)adc_block_size/(float)adc_sample_rate;
   const float busy_time = ((float)status.busy_time*1e-6f);
-  const uint8_t usb_buf_level = status.usb_buf_level;
+  const uint16_t usb_latency = status.usb_latency_ms;
+  const uint32_t usb_underruns = status.usb_underruns;
+  const uint32_t spectrum_frames = status.spectrum_frames_published;
+  const uint32_t system_clock_MHz = status.system_clock_Hz / 1000000u;
   receiver.release();
 
+  //spectrum frame rate, independent of the display refresh rate
+  static uint32_t last_spectrum_frames = 0;
+  static uint32_t last_spectrum_time = 0;
+  const uint32_t now = time_us_32();
+  const float spectrum_fps = (spectrum_frames - last_spectrum_frames) * 1e6f / (now - last_spectrum_time);
+  last_spectrum_frames = spectrum_frames;
+  last_spectrum_time = now;
+
   display_clear();
   draw_slim_status(0, status, receiver);
 
@@ -466,12 +480,17 @@ void ui::renderpage_status(rx_status & status, rx & receiver)
 
   //cpu load
   y += 10;
-  snprintf(buff, buffer_size, "CPU Load: %3.0f%%", (100.0f * busy_time) / block_time);
+  snprintf(buff, buffer_size, "CPU Load: %3.0f%% %3luM", (100.0f * busy_time) / block_time, system_clock_MHz);
+  u8g2_DrawStr(&u8g2, 0, y, buff);
+
+  //usb buffer latency and underruns
+  y += 10;
+  snprintf(buff, buffer_size, "USB Buff: %2ums %4lu", usb_latency, usb_underruns);
   u8g2_DrawStr(&u8g2, 0, y, buff);
 
-  //usb buffer
+  //spectrum frames
   y += 10;
-  snprintf(buff, buffer_size, "USB Buff: %3d%%", usb_buf_level);
+  snprintf(buff, buffer_size, "Spectrum: %3.0ffps", spectrum_fps);
   u8g2_DrawStr(&u8g2, 0, y, buff);
 
   display_show();
@@ -538,6 +557,12 @@ float ui::S_to_dBm(int S) {
   return (dBm);
 }
 
+//squelch level to draw on the signal strength meters (SNR squelch has no level)
+float ui::squelch_dBm() {
+  if (settings[idx_squelch] >= squelch_snr_first) return S0;
+  return S_to_dBm(settings[idx_squelch]);
+}
+
 int32_t ui::dBm_to_63px(float power_dBm) {
   int32_t power = floorf((power_dBm-S0));
   power = power * 63 / (S9_10 + 20 - S0);
@@ -751,9 +776,12 @@ void ui::draw_spectrum(uint16_t startY, uint16_t endY)
   const uint8_t scale = 256/max_height;
   int16_t y=0, smoothed_y=0;
 
+  //the narrowband spectrum is zoomed in the receiver, wideband is cropped here
+  const bool wideband = (settings[idx_bandwidth_spectrum] >> flag_wideband_spectrum) & 1;
+
   for(uint16_t x=0; x<128; x++)
   {
-    if(spectrum_zoom == 1) y = spectrum[x*2]/scale;
+    if(spectrum_zoom == 1 || !wideband) y = spectrum[x*2]/scale;
     else if(spectrum_zoom == 2) y = spectrum[64+x]/scale;
     else if(spectrum_zoom == 3) y = spectrum[96+(x>>1)]/scale;
     else if(spectrum_zoom == 4) y = spectrum[112+(x>>2)]/scale;
@@ -1045,6 +1073,17 @@ void ui::apply_settings(bool suspend, bool settings_changed)
   settings_to_apply.band_7_limit = ((settings[idx_band2] >> 16) & 0xff);
   settings_to_apply.ppm = (settings[idx_hw_setup] & mask_ppm) >> flag_ppm;
   settings_to_apply.iq_correction = settings[idx_rx_features] >> flag_iq_correction & 1;
+  settings_to_apply.bass = (int32_t)((settings[idx_rx_features] & mask_bass) << (28 - flag_bass)) >> 28;
+  settings_to_apply.treble = (int32_t)((settings[idx_rx_features] & mask_treble) << (28 - flag_treble)) >> 28;
+  settings_to_apply.dual_watch = (settings[idx_dual_watch] >> flag_dual_watch_enable) & 1;
+  settings_to_apply.dual_watch_offset_Hz = 100 * (int8_t)((settings[idx_dual_watch] & mask_dual_watch_offset) >> flag_dual_watch_offset);
+  settings_to_apply.dual_watch_mode = (settings[idx_dual_watch] & mask_dual_watch_mode) >> flag_dual_watch_mode;
+  settings_to_apply.wideband_spectrum = (settings[idx_bandwidth_spectrum] >> flag_wideband_spectrum) & 1;
+  settings_to_apply.spectrum_calibrated = (settings[idx_bandwidth_spectrum] >> flag_spectrum_calibrated) & 1;
+  settings_to_apply.spectrum_average = (settings[idx_bandwidth_spectrum] & mask_spectrum_average) >> flag_spectrum_average;
+  settings_to_apply.spectrum_zoom = (settings[idx_bandwidth_spectrum] & mask_spectrum) >> flag_spectrum;
+  settings_to_apply.usb_latency = (settings[idx_hw_setup] & mask_usb_latency) >> flag_usb_latency;
+  settings_to_apply.usb_iq = (settings[idx_hw_setup] >> flag_usb_iq) & 1;
   receiver.release();
 }
 
@@ -1182,6 +1221,9 @@ void ui::autorestore()
     settings[i] = autosave_memory[last_channel_written][i];
   }
 
+  //dual watch was added later, older autosaves leave the entry erased
+  if(settings[idx_dual_watch] == 0xffffffff) settings[idx_dual_watch] = 0;
+
   apply_settings(false);
   uint8_t display_timeout_setting = (settings[idx_hw_setup] & mask_display_timeout) >> flag_display_timeout;
   display_timeout_max = timeout_lookup[display_timeout_setting];
@@ -1517,7 +1559,7 @@ bool ui::memory_recall(bool &ok)
   if(abs(power_dBm - last_power_dBm) > 1.0f)
   {
     // draw vertical signal strength
-    draw_vertical_dBm( 124, power_dBm, S_to_dBm(settings[idx_squelch]));
+    draw_vertical_dBm( 124, power_dBm, squelch_dBm());
     display_show();
   }
 
@@ -1570,9 +1612,9 @@ bool ui::memory_scan(bool &ok)
     static float last_power_dBm = FLT_MAX;
     receiver.access(false);
     power_dBm = status.signal_strength_dBm;
+    listen = status.squelch_open;
     receiver.release();
     update_display = abs(power_dBm - last_power_dBm) > 1.0f;
-    listen = (power_dBm >= S_to_dBm(settings[idx_squelch]));
 
     //hang for 3 seconds
     static uint32_t last_listen_time = 0u;
@@ -1712,7 +1754,7 @@ bool ui::memory_scan(bool &ok)
       display_print_str("Speed",2);
       display_print_speed(91, display_get_y(), 2, scan_speed);
     }
-    draw_vertical_dBm( 124, power_dBm, S_to_dBm(settings[idx_squelch]));
+    draw_vertical_dBm( 124, power_dBm, squelch_dBm());
     display_show();
   }
 
@@ -1773,9 +1815,9 @@ bool ui::frequency_scan(bool &ok)
     static float last_power_dBm = FLT_MAX;
     receiver.access(false);
     power_dBm = status.signal_strength_dBm;
+    listen = status.squelch_open;
     receiver.release();
     update_display = abs(power_dBm - last_power_dBm) > 1.0f;
-    listen = (power_dBm >= S_to_dBm(settings[idx_squelch]));
 
     //hang for 3 seconds
     static uint32_t last_listen_time = 0u;
@@ -1902,7 +1944,7 @@ bool ui::frequency_scan(bool &ok)
         display_print_speed(91, display_get_y(), 2, scan_speed);
       }
 
-      draw_vertical_dBm( 124, power_dBm, S_to_dBm(settings[idx_squelch]));
+      draw_vertical_dBm( 124, power_dBm, squelch_dBm());
       display_show();
   }
 
@@ -2212,7 +2254,7 @@ bool ui::configuration_menu(bool &ok)
     //chose menu item
     if(ui_state == select_menu_item)
     {
-      if(menu_entry("HW Config", "Display\nTimeout#Regulator\nMode#Reverse\nEncoder#Encoder\nResolution#Swap IQ#Gain Cal#Freq Cal#Flip OLED#OLED Type#Display\nContrast#TFT\nSettings#TFT Colour#Bands#USB\nUpload#", &menu_selection, ok))
+      if(menu_entry("HW Config", "Display\nTimeout#Regulator\nMode#Reverse\nEncoder#Encoder\nResolution#Swap IQ#Gain Cal#Freq Cal#Flip OLED#OLED Type#Display\nContrast#TFT\nSettings#TFT Colour#Bands#USB\nLatency#USB\nAudio#USB\nUpload#", &menu_selection, ok))
       {
         if(ok) 
         {
@@ -2326,7 +2368,23 @@ bool ui::configuration_menu(bool &ok)
           done = bands_menu(ok);
           break;
 
-        case 13: 
+        case 13:
+          setting_word = (settings[idx_hw_setup] & mask_usb_latency) >> flag_usb_latency;
+          done = enumerate_entry("USB\nLatency", "10ms#20ms#50ms#", &setting_word, ok, changed);
+          settings[idx_hw_setup] &= ~mask_usb_latency;
+          settings[idx_hw_setup] |= setting_word << flag_usb_latency;
+          if(changed) apply_settings(false);
+          break;
+
+        case 14:
+          setting_word = (settings[idx_hw_setup] >> flag_usb_iq) & 1;
+          done = enumerate_entry("USB\nAudio", "Audio#IQ#", &setting_word, ok, changed);
+          settings[idx_hw_setup] &= ~(1 << flag_usb_iq);
+          settings[idx_hw_setup] |= setting_word << flag_usb_iq;
+          if(changed) apply_settings(false);
+          break;
+
+        case 15: 
           setting_word = 0;
           enumerate_entry("USB Upload", "Back#Memory#Firmware#", &setting_word, ok, changed);
           if(setting_word==1) {
@@ -2360,7 +2418,7 @@ bool ui::main_menu(bool & ok)
     //chose menu item
     if(ui_state == select_menu_item)
     {
-      if(menu_entry("Menu", "Frequency#Recall#Store#Volume#Mode#AGC Speed#Bandwidth#Squelch#Auto Notch#De-\nEmphasis#IQ\nCorrection#Spectrum\nZoom#Band Start#Band Stop#Frequency\nStep#CW Tone\nFrequency#HW Config#", &menu_selection, ok))
+      if(menu_entry("Menu", "Frequency#Recall#Store#Volume#Mode#AGC Speed#Bandwidth#Squelch#Auto Notch#De-\nEmphasis#Bass#Treble#IQ\nCorrection#Spectrum\nZoom#Wideband\nSpectrum#Spectrum\nScale#Spectrum\nAverage#Band Start#Band Stop#Frequency\nStep#CW Tone\nFrequency#Dual\nWatch#HW Config#", &menu_selection, ok))
       {
         if(ok) 
         {
@@ -2415,7 +2473,7 @@ bool ui::main_menu(bool & ok)
             if(changed) apply_settings(false);
             break;
           case 7 :  
-            done = enumerate_entry("Squelch", "S0#S1#S2#S3#S4#S5#S6#S7#S8#S9#S9+10dB#S9+20dB#S9+30dB#", &settings[idx_squelch], ok, changed);
+            done = enumerate_entry("Squelch", "S0#S1#S2#S3#S4#S5#S6#S7#S8#S9#S9+10dB#S9+20dB#S9+30dB#SNR 3dB#SNR 6dB#SNR 10dB#SNR 15dB#SNR 20dB#", &settings[idx_squelch], ok, changed);
             if(changed) apply_settings(false);
             break;
           case 8 :  
@@ -2428,30 +2486,62 @@ bool ui::main_menu(bool & ok)
             settings[idx_rx_features] |= ((settings_word << flag_deemphasis) & mask_deemphasis);
             if(changed) apply_settings(false);
             break;
-          case 10 : 
+          case 10 :
+          case 11 :
+          {
+            //tone controls are stored as signed 4 bit values in 2dB steps
+            const uint8_t flag = (menu_selection == 10) ? flag_bass : flag_treble;
+            const uint32_t mask = 0xfu << flag;
+            int32_t tone = (int32_t)((settings[idx_rx_features] & mask) << (28 - flag)) >> 28;
+            done = number_entry((menu_selection == 10) ? "Bass" : "Treble", "%idB", -6, 6, 2, &tone, ok, changed);
+            settings[idx_rx_features] &= ~mask;
+            settings[idx_rx_features] |= (((uint32_t)tone & 0xfu) << flag);
+            if(changed) apply_settings(false);
+            break;
+          }
+          case 12 : 
             done = bit_entry("IQ\ncorrection", "Off#On#", flag_iq_correction, &settings[idx_rx_features], ok);
             break;
-          case 11 : 
+          case 13 : 
             settings_word = (settings[idx_bandwidth_spectrum] & mask_spectrum) >> flag_spectrum;
             done = number_entry("Spectrum\nZoom Level", "%i", 1, 4, 1, (int32_t*)&settings_word, ok, changed);
             settings[idx_bandwidth_spectrum] &= ~(mask_spectrum);
             settings[idx_bandwidth_spectrum] |= ((settings_word << flag_spectrum) & mask_spectrum);
+            if(changed) apply_settings(false);
             break;
-          case 12 :  
+          case 14 :
+            done = bit_entry("Wideband\nSpectrum", "Off#On#", flag_wideband_spectrum, &settings[idx_bandwidth_spectrum], ok);
+            if(done) apply_settings(false);
+            break;
+          case 15 :
+            done = bit_entry("Spectrum\nScale", "Auto#dBm#", flag_spectrum_calibrated, &settings[idx_bandwidth_spectrum], ok);
+            if(done) apply_settings(false);
+            break;
+          case 16 :
+            settings_word = (settings[idx_bandwidth_spectrum] & mask_spectrum_average) >> flag_spectrum_average;
+            done = enumerate_entry("Spectrum\nAverage", "Fast#Slow#Very Slow#Linear#Peak Hold#Min Hold#", &settings_word, ok, changed);
+            settings[idx_bandwidth_spectrum] &= ~(mask_spectrum_average);
+            settings[idx_bandwidth_spectrum] |= ((settings_word << flag_spectrum_average) & mask_spectrum_average);
+            if(changed) apply_settings(false);
+            break;
+          case 17 :  
             done = frequency_entry("Band Start", idx_min_frequency, ok);
             break;
-          case 13 : 
+          case 18 : 
             done = frequency_entry("Band Stop", idx_max_frequency, ok);
             break;
-          case 14 : 
+          case 19 : 
             done = enumerate_entry("Frequency\nStep", "10Hz#50Hz#100Hz#1kHz#5kHz#9kHz#10kHz#12.5kHz#25kHz#50kHz#100kHz#", &settings[idx_step], ok, changed);
             settings[idx_frequency] -= settings[idx_frequency]%step_sizes[settings[idx_step]];
             break;
-          case 15 : 
+          case 20 : 
             done = number_entry("CW Tone\nFrequency", "%iHz", 1, 30, 100, (int32_t*)&settings[idx_cw_sidetone], ok, changed);
             if(changed) apply_settings(false);
             break;
-          case 16 : 
+          case 21 :
+            done = dual_watch_menu(ok);
+            break;
+          case 22 : 
             done = configuration_menu(ok);
             break;
         }
@@ -2555,6 +2645,73 @@ bool ui::bands_menu(bool &ok)
     return false;
 }
 
+bool ui::dual_watch_menu(bool &ok)
+{
+    enum e_ui_state {select_menu_item, menu_item_active};
+    static e_ui_state ui_state = select_menu_item;
+    static uint32_t menu_selection = 0;
+
+    //chose menu item
+    if(ui_state == select_menu_item)
+    {
+      if(menu_entry("Dual Watch", "Enable#Offset#Mode#", &menu_selection, ok))
+      {
+        if(ok) 
+        {
+          //ok button pressed, more work to do
+          ui_state = menu_item_active;
+          return false;
+        }
+        else
+        {
+          //cancel button pressed, done with menu
+          menu_selection = 0;
+          ui_state = select_menu_item;
+          return true;
+        }
+      }
+    }
+
+    //menu item active
+    else if(ui_state == menu_item_active)
+    {
+       bool done = false;
+       bool changed = false;
+       uint32_t settings_word;
+       int32_t offset;
+       switch(menu_selection)
+        {
+          case 0 :
+            done = bit_entry("Dual Watch", "Off#On#", flag_dual_watch_enable, &settings[idx_dual_watch], ok);
+            if(done) apply_settings(false);
+            break;
+          case 1 :
+            //offset from the main frequency, must stay within the captured bandwidth
+            offset = (int8_t)((settings[idx_dual_watch] & mask_dual_watch_offset) >> flag_dual_watch_offset);
+            done = number_entry("Offset", "%iHz", -100, 100, 100, &offset, ok, changed);
+            settings[idx_dual_watch] &= ~(mask_dual_watch_offset);
+            settings[idx_dual_watch] |= (((uint32_t)offset << flag_dual_watch_offset) & mask_dual_watch_offset);
+            if(changed) apply_settings(false);
+            break;
+          case 2 :
+            settings_word = (settings[idx_dual_watch] & mask_dual_watch_mode) >> flag_dual_watch_mode;
+            done = enumerate_entry("Mode", "AM#AM-Sync#LSB#USB#FM#CW#", &settings_word, ok, changed);
+            settings[idx_dual_watch] &= ~(mask_dual_watch_mode);
+            settings[idx_dual_watch] |= ((settings_word << flag_dual_watch_mode) & mask_dual_watch_mode);
+            if(changed) apply_settings(false);
+            break;
+        }
+        if(done)
+        {
+          menu_selection = 0;
+          ui_state = select_menu_item;
+          return true;
+        }
+    }
+
+    return false;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // This is the startup animation
 ////////////////////////////////////////////////////////////////////////////////
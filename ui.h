@@ -54,6 +54,7 @@ const uint8_t PIN_DISPLAY_SCL = 19;
 #define idx_rx_features 12
 #define idx_band1 13
 #define idx_band2 14
+#define idx_dual_watch 15
 
 // bit flags for HW settings in idx_hw_setup
 #define flag_reverse_encoder 0
@@ -69,6 +70,9 @@ const uint8_t PIN_DISPLAY_SCL = 19;
 #define flag_tft_colour 15   // bits 15
 #define mask_tft_colour (0x1 << flag_tft_colour)
 #define flag_encoder_res 16
+#define flag_usb_latency 17   // bits 17-18
+#define mask_usb_latency (0x3 << flag_usb_latency)
+#define flag_usb_iq 19
 #define flag_ppm 24   // bits 24-31
 #define mask_ppm (0xff << flag_ppm)
 
@@ -77,6 +81,12 @@ const uint8_t PIN_DISPLAY_SCL = 19;
 #define mask_bandwidth (0xf << flag_bandwidth)
 #define flag_spectrum 4 // bits 4-7
 #define mask_spectrum (0xf << flag_spectrum)
+#define flag_wideband_spectrum 8 // bit 8, show 240kHz from raw adc samples
+#define mask_wideband_spectrum (0x1 << flag_wideband_spectrum)
+#define flag_spectrum_calibrated 9 // bit 9, fixed dBm scale rather than auto range
+#define mask_spectrum_calibrated (0x1 << flag_spectrum_calibrated)
+#define flag_spectrum_average 10 // bits 10-12
+#define mask_spectrum_average (0x7 << flag_spectrum_average)
 
 //flags for receiver features idx_rx_features
 #define flag_enable_auto_notch (0)
@@ -85,6 +95,18 @@ const uint8_t PIN_DISPLAY_SCL = 19;
 #define mask_deemphasis (0x3 << flag_deemphasis)
 #define flag_iq_correction (3)
 #define mask_iq_correction (0x1 << flag_iq_correction)
+#define flag_bass (4) // bits 4-7, signed 2dB steps
+#define mask_bass (0xf << flag_bass)
+#define flag_treble (8) // bits 8-11, signed 2dB steps
+#define mask_treble (0xf << flag_treble)
+
+//flags for idx_dual_watch
+#define flag_dual_watch_offset 0 // bits 0-7, signed 100Hz steps
+#define mask_dual_watch_offset (0xff << flag_dual_watch_offset)
+#define flag_dual_watch_mode 8 // bits 8-11
+#define mask_dual_watch_mode (0xf << flag_dual_watch_mode)
+#define flag_dual_watch_enable 12
+#define mask_dual_watch_enable (0x1 << flag_dual_watch_enable)
 
 // define wait macros
 #define WAIT_10MS sleep_us(10000);
@@ -184,6 +206,7 @@ class ui
 
   int dBm_to_S(float power_dBm);
   float S_to_dBm(int S);
+  float squelch_dBm();
   int32_t dBm_to_63px(float power_dBm);
   void log_spectrum(float *min, float *max, int zoom = 1);
   void draw_h_tick_marks(uint16_t startY);
@@ -206,6 +229,7 @@ class ui
   bool main_menu(bool &ok);
   bool configuration_menu(bool &ok);
   bool bands_menu(bool &ok);
+  bool dual_watch_menu(bool &ok);
 
   //menu items
   void print_enum_option(const char options[], uint8_t option);
@@ -34,7 +34,7 @@ uint8_t clkValid;
 
 // Range states
 audio_control_range_2_n_t(1) volumeRng[CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX+1]; 			// Volume range state
-audio_control_range_4_n_t(1) sampleFreqRng; 						// Sample frequency range state
+audio_control_range_4_n_t(2) sampleFreqRng; 						// Sample frequency range state
 
 static usb_audio_device_tx_ready_handler_t usb_audio_device_tx_ready_handler = NULL;
 static usb_audio_device_mutevol_handler_t usb_audio_device_mutevol_handler = NULL;
@@ -48,10 +48,18 @@ void usb_audio_device_init()
   sampFreq = USB_A_SAMPLE_RATE;
   clkValid = 1;
 
-  sampleFreqRng.wNumSubRanges = 1;
+  sampleFreqRng.wNumSubRanges = 2;
   sampleFreqRng.subrange[0].bMin = USB_A_SAMPLE_RATE;
   sampleFreqRng.subrange[0].bMax = USB_A_SAMPLE_RATE;
   sampleFreqRng.subrange[0].bRes = 0;
+  sampleFreqRng.subrange[1].bMin = USB_A_HIGH_SAMPLE_RATE;
+  sampleFreqRng.subrange[1].bMax = USB_A_HIGH_SAMPLE_RATE;
+  sampleFreqRng.subrange[1].bRes = 0;
+}
+
+uint32_t usb_audio_device_get_sample_rate()
+{
+  return sampFreq;
 }
 
 void usb_audio_device_set_tx_ready_handler(usb_audio_device_tx_ready_handler_t handler)
@@ -173,6 +181,19 @@ bool tud_audio_set_req_entity_cb(uint8_t rhport, tusb_control_request_t const *
       return false;
     }
   }
+
+  // Clock source, the host selects one of the two sample rates
+  if ( entityID == 4 && ctrlSel == AUDIO_CS_CTRL_SAM_FREQ )
+  {
+    TU_VERIFY(p_request->wLength == sizeof(audio_control_cur_4_t));
+
+    uint32_t requested = (uint32_t)((audio_control_cur_4_t*) pBuff)->bCur;
+    TU_VERIFY(requested == USB_A_SAMPLE_RATE || requested == USB_A_HIGH_SAMPLE_RATE);
+    sampFreq = requested;
+
+    TU_LOG2("    Set Sample Freq: %lu\r\n", sampFreq);
+    return true;
+  }
   return false;    // Yet not implemented
 }
 
@@ -230,8 +251,8 @@ bool tud_audio_get_req_entity_cb(uint8_t rhport, tusb_control_request_t const *
       audio_desc_channel_cluster_t ret;
 
       // Those are dummy values for now
-      ret.bNrChannels = 1;
-      ret.bmChannelConfig = 0;
+      ret.bNrChannels = CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX;
+      ret.bmChannelConfig = AUDIO_CHANNEL_CONFIG_FRONT_LEFT | AUDIO_CHANNEL_CONFIG_FRONT_RIGHT;
       ret.iChannelNames = 0;
 
       TU_LOG2("    Get terminal connector\r\n");
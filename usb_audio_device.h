@@ -11,6 +11,7 @@
 #include "tusb.h"
 
 #define USB_A_SAMPLE_RATE (15000)
+#define USB_A_HIGH_SAMPLE_RATE (48000) // resampled on the device
 #define SAMPLE_BUFFER_SIZE ((CFG_TUD_AUDIO_EP_SZ_IN / 2) - 1)
 
 #ifdef __cplusplus
@@ -26,6 +27,7 @@ extern "C"
     void usb_audio_device_set_mutevol_handler(usb_audio_device_mutevol_handler_t handler);
     void usb_audio_device_task();
     uint16_t usb_audio_device_write(const void *data, uint16_t len);
+    uint32_t usb_audio_device_get_sample_rate();
 
 #ifdef __cplusplus
 }
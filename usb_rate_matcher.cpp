@@ -0,0 +1,118 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: usb_rate_matcher.cpp
+// description: match the audio rate to the USB host clock
+// License: MIT
+//
+
+#include "usb_rate_matcher.h"
+
+#ifndef SIMULATION
+#include "pico/stdlib.h"
+#endif
+
+static const uint32_t unity = 1u << 24;
+
+usb_rate_matcher::usb_rate_matcher()
+{
+  target_level = 0;
+  reset();
+}
+
+void usb_rate_matcher::reset()
+{
+  for(uint8_t channel = 0; channel < 2; ++channel)
+  {
+    history[channel][0] = history[channel][1] = history[channel][2] = 0;
+  }
+  phase = 0;
+  step = unity;
+  level_avg = 0;
+  integral_ppm = 0;
+  ratio_ppm = 0;
+  settled = false;
+}
+
+void usb_rate_matcher::update(uint16_t level)
+{
+  //the host takes samples in 1ms packets, smooth out the packet jitter
+  const int32_t level_8 = (int32_t)level << 8;
+  if(!settled)
+  {
+    level_avg = level_8;
+    settled = true;
+  }
+  level_avg = level_avg - (level_avg >> 4) + (level_8 >> 4);
+
+  //too full, produce fewer samples
+  const int32_t error = level_avg - ((int32_t)target_level << 8);
+  const int32_t max_integral = usb_rate_max_ppm << 8;
+  integral_ppm -= error >> 6;
+  integral_ppm = integral_ppm > max_integral ? max_integral : integral_ppm;
+  integral_ppm = integral_ppm < -max_integral ? -max_integral : integral_ppm;
+
+  ratio_ppm = (integral_ppm - 2 * error) >> 8;
+  ratio_ppm = ratio_ppm > usb_rate_max_ppm ? usb_rate_max_ppm : ratio_ppm;
+  ratio_ppm = ratio_ppm < -usb_rate_max_ppm ? -usb_rate_max_ppm : ratio_ppm;
+
+  //step = 1/(1 + ppm) to first order, the controller absorbs the error
+  step = unity - (((int64_t)ratio_ppm << 24) / 1000000);
+}
+
+//Catmull-Rom coefficients for outputs between h1 and h2, doubled to avoid halves
+struct s_catmull_rom
+{
+  int32_t c0, c1, c2, c3;
+};
+
+static inline s_catmull_rom catmull_rom(int16_t history[], int16_t h3)
+{
+  const int32_t h0 = history[0];
+  const int32_t h1 = history[1];
+  const int32_t h2 = history[2];
+  history[0] = h1;
+  history[1] = h2;
+  history[2] = h3;
+  return {2 * h1, h2 - h0, 2 * h0 - 5 * h1 + 4 * h2 - h3, h3 - h0 + 3 * (h1 - h2)};
+}
+
+static inline int16_t interpolate(const s_catmull_rom &c, int64_t t)
+{
+  int64_t y = ((c.c3 * t) >> 16) + c.c2;
+  y = ((y * t) >> 16) + c.c1;
+  y = ((y * t) >> 16) + c.c0;
+  y >>= 1;
+  y = y > INT16_MAX ? INT16_MAX : y;
+  y = y < INT16_MIN ? INT16_MIN : y;
+  return y;
+}
+
+#ifndef SIMULATION
+uint16_t __not_in_flash_func(usb_rate_matcher::process_block)(const int16_t left[], const int16_t right[], uint16_t num_samples, int16_t out[])
+#else
+uint16_t usb_rate_matcher::process_block(const int16_t left[], const int16_t right[], uint16_t num_samples, int16_t out[])
+#endif
+{
+  uint16_t num_out = 0;
+  for(uint16_t idx = 0; idx < num_samples; ++idx)
+  {
+    const s_catmull_rom l = catmull_rom(history[0], left[idx]);
+    const s_catmull_rom r = catmull_rom(history[1], right[idx]);
+    while(phase < unity)
+    {
+      const int64_t t = phase >> 8; //16 bits
+      out[2 * num_out] = interpolate(l, t);
+      out[2 * num_out + 1] = interpolate(r, t);
+      ++num_out;
+      phase += step;
+    }
+    phase -= unity;
+  }
+  return num_out;
+}
@@ -0,0 +1,53 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: usb_rate_matcher.h
+// description: match the audio rate to the USB host clock
+// License: MIT
+//
+
+#ifndef USB_RATE_MATCHER_H
+#define USB_RATE_MATCHER_H
+#include <stdint.h>
+
+//the host and the adc clocks differ by at most a few hundred ppm
+static const int32_t usb_rate_max_ppm = 2000;
+
+//The USB host takes samples at a rate derived from its own clock. The fill
+//level of the USB buffer is measured before each block is added, and a PI
+//controller adjusts the ratio of a fractional (Catmull-Rom) resampler to
+//hold it at the target level. Both channels share the same resampler phase.
+class usb_rate_matcher
+{
+  //resampler
+  int16_t history[2][3];
+  uint32_t phase; //24 fractional bits
+  uint32_t step;  //input samples per output sample, 24 fractional bits
+
+  //controller, levels in samples with 8 fractional bits
+  uint16_t target_level;
+  int32_t level_avg;
+  int32_t integral_ppm; //8 fractional bits
+  int32_t ratio_ppm;
+  bool settled;
+
+  public:
+  usb_rate_matcher();
+  void set_target_level(uint16_t samples){target_level = samples;}
+  void reset();
+
+  //buffer level in samples before the next block is added
+  void update(uint16_t level);
+  int32_t get_ratio_ppm(){return ratio_ppm;}
+
+  //out holds interleaved left/right pairs and must have room for
+  //num_samples + 2 pairs, returns the number of output pairs
+  uint16_t process_block(const int16_t left[], const int16_t right[], uint16_t num_samples, int16_t out[]);
+};
+
+#endif
@@ -4,6 +4,10 @@
 
 int16_t sin_table[2048];
 
+//log2(1 + i/64) with 8 fractional bits
+static const uint8_t log2_mantissa_bits = 6u;
+static uint8_t log2_table[1 << log2_mantissa_bits];
+
 //from: http://dspguru.com/dsp/tricks/magnitude-estimator/
 uint16_t rectangular_2_magnitude(int16_t i, int16_t q)
 {
@@ -41,6 +45,21 @@ int16_t rectangular_2_phase(int16_t i, int16_t q)
    else return(angle);
 }
 
+int32_t magnitude_2_dB(uint32_t magnitude)
+{
+  if(magnitude == 0) return 0;
+
+  //integer part from the position of the leading one,
+  //fractional part from the bits that follow it
+  const uint8_t msb = 31u - __builtin_clz(magnitude);
+  const uint32_t normalised = magnitude << (31u - msb);
+  const uint8_t mantissa = (normalised >> (31u - log2_mantissa_bits)) & ((1u << log2_mantissa_bits) - 1u);
+  const int32_t log2_magnitude = ((int32_t)msb << 8) + log2_table[mantissa];
+
+  //20log10(x) = 6.0206 * log2(x)
+  return (log2_magnitude * 1541) >> 8;
+}
+
 void initialise_luts()
 {
   //pre-generate sin/cos lookup tables
@@ -49,4 +68,9 @@ void initialise_luts()
   {
     sin_table[idx] = roundf(sinf(2.0*M_PI*idx/2048.0) * scaling_factor);
   }
+
+  for(uint8_t idx=0; idx<(1 << log2_mantissa_bits); idx++)
+  {
+    log2_table[idx] = roundf(256.0f * log2f(1.0f + (float)idx/(1 << log2_mantissa_bits)));
+  }
 }
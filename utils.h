@@ -8,6 +8,8 @@ extern int16_t sin_table[2048];
 uint16_t rectangular_2_magnitude(int16_t i, int16_t q);
 //from: https://dspguru.com/dsp/tricks/fixed-point-atan2-with-self-normalization/
 int16_t rectangular_2_phase(int16_t i, int16_t q);
+//20log10(magnitude) with 8 fractional bits, using count leading zeros and a mantissa table
+int32_t magnitude_2_dB(uint32_t magnitude);
 
 void initialise_luts();
 
@@ -0,0 +1,111 @@
+#!/usr/bin/env python
+"""Capture raw adc blocks from the PicoRX over the vendor bulk endpoint.
+
+The capture is saved exactly as sent by the device, a 32 byte header
+followed by the 12 bit samples as little endian uint16 (I on the even
+samples unless the swap iq flag is set). Use load_capture to read a saved
+file into numpy, e.g. as a replay vector for the DSP benchmarks.
+
+Requires pyusb. On Windows, bind the vendor interface to WinUSB first (e.g.
+with Zadig).
+"""
+import argparse
+import struct
+
+import numpy as np
+
+VENDOR_ID = 0xCAFE
+PRODUCT_ID = 0x4031
+MAGIC = 0x43585250  # "PRXC"
+HEADER_FORMAT = "<IHHHHIII8x"
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+COMMAND = ord("C")
+MAX_BLOCKS = 4
+
+FLAG_DISCONTINUOUS = 1
+FLAG_SWAP_IQ = 2
+
+
+def parse_capture(data):
+    """Split a capture into a header dictionary and complex I/Q samples."""
+    (magic, header_size, num_blocks, block_size, flags, sample_rate,
+     first_block, nco_frequency_Hz) = struct.unpack_from(HEADER_FORMAT, data)
+    if magic != MAGIC:
+        raise ValueError("not an adc capture")
+    header = {
+        "num_blocks": num_blocks,
+        "block_size": block_size,
+        "flags": flags,
+        "sample_rate": sample_rate,
+        "first_block": first_block,
+        "nco_frequency_Hz": nco_frequency_Hz,
+        "discontinuous": bool(flags & FLAG_DISCONTINUOUS),
+    }
+    raw = np.frombuffer(data, dtype="<u2", offset=header_size,
+                        count=num_blocks * block_size)
+    i, q = raw[0::2], raw[1::2]
+    if flags & FLAG_SWAP_IQ:
+        i, q = q, i
+    return header, raw, i.astype(float) + 1j * q.astype(float)
+
+
+def load_capture(path):
+    with open(path, "rb") as f:
+        return parse_capture(f.read())
+
+
+def capture(num_blocks, timeout_ms=2000):
+    import usb.core
+    import usb.util
+
+    dev = usb.core.find(idVendor=VENDOR_ID, idProduct=PRODUCT_ID)
+    if dev is None:
+        raise IOError("PicoRX not found")
+    cfg = dev.get_active_configuration()
+    intf = usb.util.find_descriptor(cfg, bInterfaceClass=0xFF)
+    ep_out = usb.util.find_descriptor(
+        intf, custom_match=lambda e: usb.util.endpoint_direction(e.bEndpointAddress) == usb.util.ENDPOINT_OUT)
+    ep_in = usb.util.find_descriptor(
+        intf, custom_match=lambda e: usb.util.endpoint_direction(e.bEndpointAddress) == usb.util.ENDPOINT_IN)
+
+    # reads are whole packets, the header gives the total length
+    ep_out.write(bytes([COMMAND, num_blocks]))
+    data = b""
+    total = HEADER_SIZE
+    while len(data) < total:
+        data += bytes(ep_in.read(4096, timeout_ms))
+        if len(data) >= HEADER_SIZE:
+            num_blocks, block_size = struct.unpack_from("<HH", data, 6)
+            total = HEADER_SIZE + 2 * num_blocks * block_size
+    return data[:total]
+
+
+def summary(header, raw, iq):
+    print("blocks %u x %u samples at %u Hz, first block %u, nco %u Hz%s" % (
+        header["num_blocks"], header["block_size"], header["sample_rate"],
+        header["first_block"], header["nco_frequency_Hz"],
+        ", DISCONTINUOUS" if header["discontinuous"] else ""))
+    print("DC offset I %.1f Q %.1f" % (iq.real.mean(), iq.imag.mean()))
+    print("clipped samples %u" % np.count_nonzero((raw == 0) | (raw >= 4095)))
+
+    # strongest spur in the complex spectrum, DC removed
+    x = iq - iq.mean()
+    spectrum = np.abs(np.fft.fftshift(np.fft.fft(x * np.hanning(len(x)))))
+    spectrum_dB = 20 * np.log10(spectrum / spectrum.max() + 1e-12)
+    frequencies = np.fft.fftshift(np.fft.fftfreq(len(x), 2.0 / header["sample_rate"]))
+    peak = np.argmax(spectrum)
+    image = np.argmin(np.abs(frequencies + frequencies[peak]))
+    print("peak %+.0f Hz, image %.1f dBc" % (frequencies[peak], spectrum_dB[image]))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Capture raw adc blocks from the PicoRX")
+    parser.add_argument("output", help="file to save the capture to")
+    parser.add_argument("-n", "--blocks", type=int, default=MAX_BLOCKS,
+                        help="number of consecutive blocks (1 to %u)" % MAX_BLOCKS)
+    args = parser.parse_args()
+
+    data = capture(args.blocks)
+    with open(args.output, "wb") as f:
+        f.write(data)
+    summary(*parse_capture(data))
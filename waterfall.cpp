@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
@@ -143,7 +144,7 @@ void waterfall::draw()
     display->drawLine(0,   20, 0,   239, display->colour565(255,255,255));
     display->drawLine(27,  20, 27,  239, display->colour565(255,255,255));
 
-    //5kHz ticks
+    //5kHz ticks, scaled by the wideband or zoom factor
     for(uint16_t fbin=0; fbin<256; ++fbin)
     {
       if((fbin-128)%42==0)
@@ -151,16 +152,37 @@ void waterfall::draw()
         display->drawLine(32+fbin, 122, 32+fbin, 123, COLOUR_WHITE);
       }
     }
-    display->drawString(29,  127, font_8x5, "-15", COLOUR_WHITE, COLOUR_BLACK);
-    display->drawString(70,  127, font_8x5, "-10", COLOUR_WHITE, COLOUR_BLACK);
-    display->drawString(111, 127, font_8x5, "-5",  COLOUR_WHITE, COLOUR_BLACK);
-    display->drawString(154, 127, font_8x5, "-0",  COLOUR_WHITE, COLOUR_BLACK);
-    display->drawString(199, 127, font_8x5, "5",   COLOUR_WHITE, COLOUR_BLACK);
-    display->drawString(238, 127, font_8x5, "10",  COLOUR_WHITE, COLOUR_BLACK);
-    display->drawString(279, 127, font_8x5, "15",  COLOUR_WHITE, COLOUR_BLACK);
+    const float tick_kHz = bin_shift >= 0 ? 5.0f * (1 << bin_shift) : 5.0f / (1 << -bin_shift);
+    for(int8_t tick=-3; tick<=3; ++tick)
+    {
+      char label[8];
+      snprintf(label, sizeof(label), "%.3g", tick * tick_kHz);
+      int16_t x = 160 + 42*tick - 3*strlen(label);
+      if(x < 26) x = 26;
+      display->drawString(x, 127, font_8x5, label, COLOUR_WHITE, COLOUR_BLACK);
+    }
 
 }
 
+//offset is in columns from the centre of the display
+bool waterfall::in_passband(int16_t offset, const s_filter_control &filter)
+{
+    int16_t start_bin = filter.start_bin;
+    int16_t stop_bin = filter.stop_bin;
+    if(bin_shift >= 0)
+    {
+      offset <<= bin_shift;
+    }
+    else
+    {
+      start_bin <<= -bin_shift;
+      stop_bin <<= -bin_shift;
+    }
+    const bool is_usb_col = (offset > start_bin) && (offset < stop_bin) && filter.upper_sideband;
+    const bool is_lsb_col = (-offset > start_bin) && (-offset < stop_bin) && filter.lower_sideband;
+    return is_usb_col || is_lsb_col;
+}
+
 uint16_t waterfall::heatmap(uint8_t value, bool blend, bool highlight)
 {
     uint8_t section = ((uint16_t)value*6)>>8;
@@ -249,11 +271,23 @@ int waterfall::dBm_to_S(float power_dBm) {
   return (power_s);
 }
 
-void waterfall::update_spectrum(rx &receiver, rx_settings &settings, rx_status &status, uint8_t spectrum[], uint8_t dB10)
+//returns false when there is nothing to draw
+bool waterfall::update_spectrum(rx &receiver, rx_settings &settings, rx_status &status, uint8_t spectrum[], uint8_t dB10)
 {
 
-    if(!enabled) return;
-    if(!power_state) return;
+    if(!enabled) return false;
+    if(!power_state) return false;
+
+    //redraw the frequency scale when the span changes
+    int8_t new_bin_shift = 0;
+    if(settings.wideband_spectrum) new_bin_shift = 3;
+    else if(settings.spectrum_zoom > 1) new_bin_shift = 1 - settings.spectrum_zoom;
+    if(new_bin_shift != bin_shift)
+    {
+      bin_shift = new_bin_shift;
+      refresh = true;
+      draw();
+    }
 
     const uint16_t waterfall_height = 100u;
     const uint16_t waterfall_x = 32u;
@@ -314,7 +348,7 @@ void waterfall::update_spectrum(rx &receiver, rx_settings &settings, rx_status &
         last_filtered_power = filtered_power;
         last_squelch = settings.squelch;
         uint16_t power_px = dBm_to_px(filtered_power, smeter_height);
-        uint16_t squelch_px = dBm_to_px(S_to_dBm(settings.squelch), smeter_height);
+        uint16_t squelch_px = settings.squelch < squelch_snr_first ? dBm_to_px(S_to_dBm(settings.squelch), smeter_height) : 0;
 
         uint16_t colour=heatmap(dBm_to_px(filtered_power, 255));
         display->fillRect(294, 43+smeter_height-power_px, power_px, smeter_width, colour);
@@ -360,9 +394,7 @@ void waterfall::update_spectrum(rx &receiver, rx_settings &settings, rx_status &
       for(uint16_t col=0; col<num_cols; ++col)
       {
          const int16_t fbin = col-128;
-         const bool is_usb_col = (fbin > status.filter_config.start_bin) && (fbin < status.filter_config.stop_bin) && status.filter_config.upper_sideband;
-         const bool is_lsb_col = (-fbin > status.filter_config.start_bin) && (-fbin < status.filter_config.stop_bin) && status.filter_config.lower_sideband;
-         const bool is_passband = is_usb_col || is_lsb_col;
+         const bool is_passband = in_passband(fbin, status.filter_config);
 
          uint8_t heat = waterfall_buffer[row_address][col];
          uint16_t colour=heatmap(heat, is_passband, fbin==0);
@@ -386,10 +418,8 @@ void waterfall::update_spectrum(rx &receiver, rx_settings &settings, rx_status &
       uint16_t vline[scope_height];
   
       const int16_t fbin = scope_col-128;
-      const bool is_usb_col = (fbin > status.filter_config.start_bin) && (fbin < status.filter_config.stop_bin) && status.filter_config.upper_sideband;
-      const bool is_lsb_col = (-fbin > status.filter_config.start_bin) && (-fbin < status.filter_config.stop_bin) && status.filter_config.lower_sideband;
-      const bool is_passband = is_usb_col || is_lsb_col;
-      const bool col_is_tick = (fbin%42 == 0) && fbin;
+      const bool is_passband = in_passband(fbin, status.filter_config);
+      const bool col_is_tick = ((scope_col-128)%42 == 0) && fbin;
 
 
       for(uint8_t row=0; row<scope_height; ++row)
@@ -448,5 +478,6 @@ void waterfall::update_spectrum(rx &receiver, rx_settings &settings, rx_status &
       FSM_state = update_waterfall;
       if(refresh_started){ refresh_started = false; refresh = false; }
     }
+    return true;
 }
 
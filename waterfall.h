@@ -10,12 +10,13 @@ class waterfall
   public:
   waterfall();
   ~waterfall();
-  void update_spectrum(rx &receiver, rx_settings &settings, rx_status &status, uint8_t spectrum[], uint8_t dB10);
+  bool update_spectrum(rx &receiver, rx_settings &settings, rx_status &status, uint8_t spectrum[], uint8_t dB10);
   void configure_display(uint8_t settings, bool invert_colours);
   void powerOn(bool state);
 
   private:
   void draw();
+  bool in_passband(int16_t offset, const s_filter_control &filter);
   uint16_t heatmap(uint8_t value, bool lighten = false, bool highlight = false);
   uint16_t dBm_to_px(float power_dBm, int16_t px);
   float S_to_dBm(int S);
@@ -26,6 +27,8 @@ class waterfall
   bool enabled = false;
   bool power_state = true;
   bool refresh = true;
+  //filter bins per column as a power of 2, +3 wideband, -1 to -3 zoomed
+  int8_t bin_shift = 0;
 
 };
 
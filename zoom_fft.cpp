@@ -0,0 +1,117 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: zoom_fft.cpp
+// description: spectrum magnification by decimating before the FFT
+// License: MIT
+//
+
+#include "zoom_fft.h"
+#include "fft.h"
+#include "utils.h"
+
+#ifndef SIMULATION
+#include "pico/stdlib.h"
+#endif
+
+zoom_fft::zoom_fft()
+{
+  stages = 0u;
+  reset();
+}
+
+void zoom_fft::reset()
+{
+  for(uint8_t stage=0; stage<zoom_max_stages; stage++)
+  {
+    for(uint8_t tap=0; tap<half_band_taps; tap++)
+    {
+      delay_i[stage][tap] = 0;
+      delay_q[stage][tap] = 0;
+    }
+    odd_sample[stage] = false;
+  }
+  buffer_count = 0u;
+}
+
+void zoom_fft::set_stages(uint8_t num_stages)
+{
+  if(num_stages > zoom_max_stages) num_stages = zoom_max_stages;
+  if(num_stages != stages) reset();
+  stages = num_stages;
+}
+
+//11 tap half-band filter, coefficients have 9 fractional bits
+//h = [3, 0, -25, 0, 150, 256, 150, 0, -25, 0, 3]/512
+#ifndef SIMULATION
+bool __not_in_flash_func(zoom_fft::half_band)(uint8_t stage, int16_t &i, int16_t &q)
+#else
+bool zoom_fft::half_band(uint8_t stage, int16_t &i, int16_t &q)
+#endif
+{
+  int16_t *di = delay_i[stage];
+  int16_t *dq = delay_q[stage];
+  for(uint8_t tap=half_band_taps-1u; tap>0; tap--)
+  {
+    di[tap] = di[tap-1];
+    dq[tap] = dq[tap-1];
+  }
+  di[0] = i;
+  dq[0] = q;
+
+  //only every other output is needed
+  odd_sample[stage] = !odd_sample[stage];
+  if(odd_sample[stage]) return false;
+
+  i = (3*((int32_t)di[0] + di[10]) - 25*((int32_t)di[2] + di[8]) + 150*((int32_t)di[4] + di[6]) + 256*(int32_t)di[5]) >> 9;
+  q = (3*((int32_t)dq[0] + dq[10]) - 25*((int32_t)dq[2] + dq[8]) + 150*((int32_t)dq[4] + dq[6]) + 256*(int32_t)dq[5]) >> 9;
+  return true;
+}
+
+#ifndef SIMULATION
+bool __not_in_flash_func(zoom_fft::process_block)(const int16_t real[], const int16_t imag[], uint16_t num_samples, int16_t magnitudes[])
+#else
+bool zoom_fft::process_block(const int16_t real[], const int16_t imag[], uint16_t num_samples, int16_t magnitudes[])
+#endif
+{
+  bool frame_ready = false;
+  for(uint16_t idx=0; idx<num_samples; idx++)
+  {
+    int16_t i = real[idx];
+    int16_t q = imag[idx];
+
+    bool output = true;
+    for(uint8_t stage=0; stage<stages && output; stage++)
+    {
+      output = half_band(stage, i, q);
+    }
+    if(!output) continue;
+
+    buffer_i[buffer_count] = i;
+    buffer_q[buffer_count] = q;
+    if(++buffer_count < zoom_fft_size) continue;
+    buffer_count = 0u;
+
+    //hann window and FFT
+    int16_t fft_real[zoom_fft_size];
+    int16_t fft_imag[zoom_fft_size];
+    for(uint16_t n=0; n<zoom_fft_size; n++)
+    {
+      const int32_t window = (32767 - sin_table[(8u*n + 512u) & 0x7ffu]) >> 1;
+      fft_real[n] = ((int32_t)buffer_i[n] * window) >> 15;
+      fft_imag[n] = ((int32_t)buffer_q[n] * window) >> 15;
+    }
+    fixed_fft(fft_real, fft_imag, 8);
+    for(uint16_t n=0; n<zoom_fft_size; n++)
+    {
+      magnitudes[n] = rectangular_2_magnitude(fft_real[n], fft_imag[n]);
+    }
+    frame_ready = true;
+  }
+  return frame_ready;
+}
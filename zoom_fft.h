@@ -0,0 +1,53 @@
+//  _  ___  _   _____ _     _
+// / |/ _ \/ | |_   _| |__ (_)_ __   __ _ ___
+// | | | | | |   | | | '_ \| | '_ \ / _` / __|
+// | | |_| | |   | | | | | | | | | | (_| \__ \.
+// |_|\___/|_|   |_| |_| |_|_|_| |_|\__, |___/
+//                                  |___/
+//
+// Copyright (c) Jonathan P Dawson 2024
+// filename: zoom_fft.h
+// description: spectrum magnification by decimating before the FFT
+// License: MIT
+//
+
+#ifndef ZOOM_FFT_H
+#define ZOOM_FFT_H
+#include <stdint.h>
+
+static const uint16_t zoom_fft_size = 256u;
+static const uint8_t zoom_max_stages = 3u; //up to 8x
+static const uint8_t half_band_taps = 11u;
+
+//The decimated, frequency shifted samples are decimated further by a
+//cascade of half-band filters and a 256 point FFT is taken of the
+//result. Each stage halves the span and the bin width.
+class zoom_fft
+{
+  uint8_t stages;
+
+  //half-band decimator state, one per stage
+  int16_t delay_i[zoom_max_stages][half_band_taps];
+  int16_t delay_q[zoom_max_stages][half_band_taps];
+  bool odd_sample[zoom_max_stages];
+
+  //samples waiting for the next FFT
+  int16_t buffer_i[zoom_fft_size];
+  int16_t buffer_q[zoom_fft_size];
+  uint16_t buffer_count;
+
+  bool half_band(uint8_t stage, int16_t &i, int16_t &q);
+
+  public:
+  zoom_fft();
+  void reset();
+
+  //number of half-band stages, 0 disables the zoom
+  void set_stages(uint8_t num_stages);
+  uint8_t get_stages(){return stages;}
+
+  //returns true when a new frame of FFT magnitudes is ready
+  bool process_block(const int16_t real[], const int16_t imag[], uint16_t num_samples, int16_t magnitudes[]);
+};
+
+#endif